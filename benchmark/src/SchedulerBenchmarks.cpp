@@ -0,0 +1,338 @@
+/**
+ * @file SchedulerBenchmarks.cpp
+ *
+ * This module contains the benchmarks of the Timekeeping::Scheduler class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <stdlib.h>
+#include <thread>
+#include <Timekeeping/Scheduler.hpp>
+#include <Timekeeping/TickClock.hpp>
+#include <vector>
+
+namespace {
+
+    /**
+     * This is the number of bytes set aside in front of each block of
+     * memory allocated by the program, to record the size of the block.
+     * It keeps the rest of the block aligned for any type.
+     */
+    constexpr size_t ALLOCATION_HEADER_SIZE = 16;
+
+    /**
+     * This is the number of bytes of memory currently allocated by the
+     * program with the global operator new.
+     */
+    std::atomic< int64_t > liveBytes{0};
+
+    /**
+     * This is a clock which only moves when the benchmark moves it,
+     * so that scheduled callbacks stay pending for as long as needed.
+     */
+    struct BenchmarkClock
+        : public Timekeeping::TickClock
+    {
+        // Properties
+
+        std::atomic< int64_t > currentTicks{0};
+
+        // Methods
+
+        // TickClock
+
+        virtual int64_t GetCurrentTicks() override {
+            return currentTicks;
+        }
+    };
+
+    /**
+     * Return a scheduler configuration selected by the given benchmark
+     * arguments.
+     *
+     * @param[in] backend
+     *     This is zero for the heap backend, or one for the timing wheel.
+     *
+     * @param[in] lockFreeSubmission
+     *     This indicates whether or not to use lock-free submission.
+     *
+     * @param[in] threadless
+     *     This indicates whether or not to use threadless mode.
+     *
+     * @return
+     *     The scheduler configuration is returned.
+     */
+    Timekeeping::Scheduler::Configuration MakeConfiguration(
+        int64_t backend,
+        bool lockFreeSubmission,
+        bool threadless
+    ) {
+        Timekeeping::Scheduler::Configuration configuration;
+        configuration.backend = (
+            (backend == 0)
+            ? Timekeeping::Scheduler::Backend::Heap
+            : Timekeeping::Scheduler::Backend::TimingWheel
+        );
+        configuration.tickResolution = 0.000001;
+        configuration.maxBatchSize = 1024;
+        configuration.lockFreeSubmission = lockFreeSubmission;
+        configuration.threadless = threadless;
+        return configuration;
+    }
+
+    /**
+     * This is the scheduler shared by the threads of a multi-threaded
+     * benchmark.
+     */
+    Timekeeping::Scheduler* sharedScheduler = nullptr;
+
+}
+
+void* operator new(size_t size) {
+    const auto block = (char*)malloc(size + ALLOCATION_HEADER_SIZE);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *(size_t*)block = size;
+    liveBytes += (int64_t)size;
+    return block + ALLOCATION_HEADER_SIZE;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    const auto block = (char*)pointer - ALLOCATION_HEADER_SIZE;
+    liveBytes -= (int64_t)*(size_t*)block;
+    free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+/**
+ * This measures how quickly callbacks can be scheduled, by one or more
+ * threads at once, while none of them become due.
+ */
+void ScheduleThroughput(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        sharedScheduler = new Timekeeping::Scheduler(
+            MakeConfiguration(state.range(0), state.range(1) != 0, false)
+        );
+        sharedScheduler->SetClock(std::make_shared< BenchmarkClock >());
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(
+            sharedScheduler->Schedule([]{}, std::chrono::hours(1))
+        );
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete sharedScheduler;
+        sharedScheduler = nullptr;
+    }
+}
+BENCHMARK(ScheduleThroughput)
+    ->ArgNames({"backend", "lockFree"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+/**
+ * This measures how quickly pending callbacks can be canceled.
+ */
+void CancelCost(benchmark::State& state) {
+    constexpr size_t batchSize = 10000;
+    Timekeeping::Scheduler scheduler(
+        MakeConfiguration(state.range(0), state.range(1) != 0, false)
+    );
+    scheduler.SetClock(std::make_shared< BenchmarkClock >());
+    std::vector< Timekeeping::Scheduler::Token > tokens;
+    tokens.reserve(batchSize);
+    for (auto _: state) {
+        state.PauseTiming();
+        tokens.clear();
+        for (size_t i = 0; i < batchSize; ++i) {
+            tokens.push_back(
+                scheduler.Schedule(
+                    []{},
+                    std::chrono::hours(1) + std::chrono::nanoseconds(i)
+                )
+            );
+        }
+        state.ResumeTiming();
+        for (const auto token: tokens) {
+            scheduler.Cancel(token);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(CancelCost)
+    ->ArgNames({"backend", "lockFree"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({0, 1})
+    ->Args({1, 1});
+
+/**
+ * This measures how quickly a burst of callbacks which all become due
+ * at once is called, from taking them from the timer queue to handing
+ * them to the executor.  A threadless scheduler is used so that only
+ * the work of expiring the callbacks is measured.
+ */
+void ExpiryBurst(benchmark::State& state) {
+    const auto timers = (size_t)state.range(0);
+    for (auto _: state) {
+        state.PauseTiming();
+        std::unique_ptr< Timekeeping::Scheduler > scheduler(
+            new Timekeeping::Scheduler(
+                MakeConfiguration(state.range(1), false, true)
+            )
+        );
+        scheduler->SetClock(std::make_shared< BenchmarkClock >());
+        size_t called = 0;
+        for (size_t i = 0; i < timers; ++i) {
+            (void)scheduler->Schedule(
+                [&called]{ ++called; },
+                std::chrono::microseconds((i * 7919) % timers + 1)
+            );
+        }
+        state.ResumeTiming();
+        const auto now = std::chrono::microseconds(timers + 1);
+        while (scheduler->RunDue(now) > 0) {
+        }
+        state.PauseTiming();
+        if (called != timers) {
+            state.SkipWithError("Not all timers expired");
+        }
+        scheduler.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * timers);
+}
+BENCHMARK(ExpiryBurst)
+    ->ArgNames({"timers", "backend"})
+    ->ArgsProduct({{1000, 100000, 1000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * This measures how late callbacks are called, from their due times
+ * on a real clock to the moment they start running, and reports the
+ * distribution of lateness in microseconds.
+ */
+void FiringLatency(benchmark::State& state) {
+    constexpr int64_t delay = 200000;
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.preciseWaiting = (state.range(0) != 0);
+    configuration.spinTime = 0.00005;
+    Timekeeping::Scheduler scheduler(configuration);
+    const auto clock = scheduler.GetClock().get();
+    std::vector< double > lateness;
+    lateness.reserve((size_t)state.max_iterations);
+    for (auto _: state) {
+        std::atomic< bool > called{false};
+        std::atomic< int64_t > calledAt{0};
+        const auto due = clock->GetCurrentTicks() + delay;
+        (void)scheduler.Schedule(
+            [clock, &called, &calledAt]{
+                calledAt = clock->GetCurrentTicks();
+                called = true;
+            },
+            std::chrono::nanoseconds(due)
+        );
+        while (!called) {
+            std::this_thread::yield();
+        }
+        lateness.push_back((double)(calledAt - due) / 1000.0);
+    }
+    if (lateness.empty()) {
+        return;
+    }
+    std::sort(lateness.begin(), lateness.end());
+    const auto percentile = [&lateness](double fraction){
+        return lateness[(size_t)(fraction * (double)(lateness.size() - 1))];
+    };
+    state.counters["p50_us"] = percentile(0.5);
+    state.counters["p90_us"] = percentile(0.9);
+    state.counters["p99_us"] = percentile(0.99);
+    state.counters["p999_us"] = percentile(0.999);
+    state.counters["max_us"] = lateness.back();
+}
+BENCHMARK(FiringLatency)
+    ->ArgNames({"precise"})
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(2000)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+/**
+ * This measures how much memory each pending callback takes up, with
+ * everything the scheduler allocates for it.
+ */
+void MemoryPerPendingTimer(benchmark::State& state) {
+    const auto timers = (size_t)state.range(1);
+    for (auto _: state) {
+        std::unique_ptr< Timekeeping::Scheduler > scheduler(
+            new Timekeeping::Scheduler(
+                MakeConfiguration(state.range(0), false, true)
+            )
+        );
+        scheduler->SetClock(std::make_shared< BenchmarkClock >());
+        const auto liveBytesBefore = liveBytes.load();
+        for (size_t i = 0; i < timers; ++i) {
+            (void)scheduler->Schedule([]{}, std::chrono::microseconds(i + 1));
+        }
+        state.counters["bytes_per_timer"] = (
+            (double)(liveBytes.load() - liveBytesBefore) / (double)timers
+        );
+    }
+}
+BENCHMARK(MemoryPerPendingTimer)
+    ->ArgNames({"backend", "timers"})
+    ->ArgsProduct({{0, 1}, {10000, 1000000}})
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * This measures how long it takes to shut down a scheduler with many
+ * pending callbacks, dropping all of them.
+ */
+void ShutdownWithPendingTimers(benchmark::State& state) {
+    const auto timers = (size_t)state.range(1);
+    for (auto _: state) {
+        state.PauseTiming();
+        std::unique_ptr< Timekeeping::Scheduler > scheduler(
+            new Timekeeping::Scheduler(
+                MakeConfiguration(state.range(0), false, false)
+            )
+        );
+        scheduler->SetClock(std::make_shared< BenchmarkClock >());
+        for (size_t i = 0; i < timers; ++i) {
+            (void)scheduler->Schedule([]{}, std::chrono::microseconds(i + 1));
+        }
+        state.ResumeTiming();
+        (void)scheduler->Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+        scheduler.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * timers);
+}
+BENCHMARK(ShutdownWithPendingTimers)
+    ->ArgNames({"backend", "timers"})
+    ->ArgsProduct({{0, 1}, {10000, 1000000}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
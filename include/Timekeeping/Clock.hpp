@@ -8,6 +8,8 @@
  * © 2019 by Richard Walters
  */
 
+#include <stdint.h>
+
 namespace Timekeeping {
 
     /**
@@ -16,6 +18,15 @@ namespace Timekeeping {
      */
     class Clock {
     public:
+        // Types
+
+        /**
+         * This is the number of ticks in one second, for the methods
+         * which measure time in integer ticks rather than seconds.
+         * A tick is one nanosecond.
+         */
+        static constexpr int64_t TICKS_PER_SECOND = 1000000000;
+
         // Methods
 
         /**
@@ -27,6 +38,42 @@ namespace Timekeeping {
          *     The current time in seconds is returned.
          */
         virtual double GetCurrentTime() = 0;
+
+        /**
+         * This method returns the current time, in ticks, since the
+         * clock's reference point.
+         *
+         * The default implementation converts the value returned by
+         * GetCurrentTime.  Clocks which count time in integers natively
+         * should override this method, to avoid losing precision.
+         *
+         * @return
+         *     The current time in ticks is returned.
+         */
+        virtual int64_t GetCurrentTicks();
+
+        /**
+         * Convert the given time in seconds to ticks, rounding to the
+         * nearest tick, and saturating at the limits of the tick range.
+         *
+         * @param[in] seconds
+         *     This is the time in seconds to convert.
+         *
+         * @return
+         *     The given time in ticks is returned.
+         */
+        static int64_t SecondsToTicks(double seconds);
+
+        /**
+         * Convert the given time in ticks to seconds.
+         *
+         * @param[in] ticks
+         *     This is the time in ticks to convert.
+         *
+         * @return
+         *     The given time in seconds is returned.
+         */
+        static double TicksToSeconds(int64_t ticks);
     };
 
 }
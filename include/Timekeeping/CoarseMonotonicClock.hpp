@@ -0,0 +1,40 @@
+#pragma once
+
+/**
+ * @file CoarseMonotonicClock.hpp
+ *
+ * This module declares the Timekeeping::CoarseMonotonicClock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TickClock.hpp"
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This is a monotonic clock which trades resolution for speed.  On
+     * Linux it reads CLOCK_MONOTONIC_COARSE, which only advances once
+     * per kernel timer tick (typically every 1 to 4 milliseconds), but
+     * costs only a few nanoseconds per reading, since it just copies
+     * a value kept by the kernel.  On other systems it reads
+     * std::chrono::steady_clock, at the same cost as SteadyClock.
+     *
+     * It has the same reference point as SteadyClock on Linux, so the
+     * two may be mixed, and it's a good fit for timers which only need
+     * to be accurate to a few milliseconds.
+     */
+    class CoarseMonotonicClock
+        : public TickClock
+    {
+    public:
+        // Methods
+
+        // TickClock
+
+        virtual int64_t GetCurrentTicks() override;
+    };
+
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+/**
+ * @file Coroutines.hpp
+ *
+ * This module declares the Timekeeping::SleepUntil and
+ * Timekeeping::SleepFor functions, and defines the Scheduler methods of
+ * the same names, which let C++20 coroutines wait on a
+ * Timekeeping::Scheduler with co_await.
+ *
+ * It's only available when compiling with coroutine support.  The rest
+ * of the library doesn't need it.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#if defined(__cpp_impl_coroutine)
+
+#include "Scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <thread>
+
+namespace Timekeeping {
+
+    /**
+     * This is what a coroutine awaits in order to be suspended until a
+     * scheduler reaches a due time.  It's returned by SleepUntil and
+     * SleepFor, and is meant to be awaited right away.
+     *
+     * The awaiter lives in the frame of the awaiting coroutine, and holds
+     * the state of the wait there, so that sleeping doesn't allocate
+     * anything.  The callback it schedules only holds a pointer back to
+     * the awaiter, which fits inside the scheduler's callback wrapper.
+     *
+     * The coroutine is resumed by the scheduler's executor.  If the
+     * coroutine frame is destroyed while the coroutine is suspended, the
+     * awaiter cancels its callback, and if the callback was already on its
+     * way to being called, waits for it to be called or destroyed, without
+     * touching the coroutine.  If the callback is dropped without being
+     * called, such as when the scheduler is shut down, the coroutine stays
+     * suspended until its frame is destroyed.  If the callback can't be
+     * scheduled at all, the coroutine isn't suspended.
+     *
+     * @note
+     *     A suspended coroutine's frame shouldn't be destroyed by a
+     *     callback of the same scheduler when the scheduler's executor
+     *     calls one callback at a time, since the awaiter might then wait
+     *     for a callback which can only be called after it returns.
+     */
+    class SleepAwaiter {
+        // Lifecycle Methods
+    public:
+        ~SleepAwaiter() noexcept {
+            auto state = State::Waiting;
+            if (!state_.compare_exchange_strong(state, State::Abandoned)) {
+                return;
+            }
+            (void)scheduler_->Cancel(token_);
+            while (state_.load(std::memory_order_acquire) != State::Done) {
+                std::this_thread::yield();
+            }
+        }
+        SleepAwaiter(const SleepAwaiter&) = delete;
+        SleepAwaiter(SleepAwaiter&&) = delete;
+        SleepAwaiter& operator=(const SleepAwaiter&) = delete;
+        SleepAwaiter& operator=(SleepAwaiter&&) = delete;
+
+        /**
+         * This is the constructor of the class.
+         *
+         * @param[in] scheduler
+         *     This is the scheduler on which to wait.
+         *
+         * @param[in] due
+         *     This is the value that will be returned by the clock
+         *     associated with the scheduler, in ticks, at the moment when
+         *     the coroutine should be resumed.
+         */
+        SleepAwaiter(
+            Scheduler& scheduler,
+            std::chrono::nanoseconds due
+        )
+            : scheduler_(&scheduler)
+            , due_(due)
+        {
+        }
+
+        // Public Methods
+    public:
+        /**
+         * Return an indication of whether or not the coroutine can go on
+         * without being suspended.
+         *
+         * @return
+         *     False is always returned, since even a due time in the past
+         *     is handled by the scheduler, so that the coroutine is always
+         *     resumed by its executor.
+         */
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        /**
+         * Schedule the callback which resumes the given suspended
+         * coroutine once the due time is reached.
+         *
+         * @param[in] coroutine
+         *     This is the handle of the coroutine being suspended.
+         *
+         * @return
+         *     An indication of whether or not the coroutine should stay
+         *     suspended is returned.  It's false if the callback couldn't
+         *     be scheduled, or was already called or dropped before this
+         *     returned.
+         */
+        bool await_suspend(std::coroutine_handle<> coroutine) {
+            coroutine_ = coroutine;
+            token_ = scheduler_->Schedule(Wakeup(this), due_);
+            if (token_ == 0) {
+                return false;
+            }
+            auto state = State::Suspending;
+            return state_.compare_exchange_strong(state, State::Waiting);
+        }
+
+        /**
+         * This is called when the coroutine is resumed.
+         */
+        void await_resume() const noexcept {
+        }
+
+        // Private Types
+    private:
+        /**
+         * These are the stages through which a wait goes.
+         */
+        enum class State {
+            /**
+             * The coroutine is being suspended.
+             */
+            Suspending,
+
+            /**
+             * The coroutine is suspended, waiting for the callback.
+             */
+            Waiting,
+
+            /**
+             * The callback is resuming the coroutine.
+             */
+            Resuming,
+
+            /**
+             * The callback was called before the coroutine was fully
+             * suspended, so the coroutine goes on without being suspended.
+             */
+            FiredEarly,
+
+            /**
+             * The callback was destroyed without being called.
+             */
+            Dropped,
+
+            /**
+             * The coroutine frame is being destroyed while the callback
+             * might still be called.
+             */
+            Abandoned,
+
+            /**
+             * The callback was called or destroyed after the coroutine
+             * frame began to be destroyed, so the awaiter may go away.
+             */
+            Done,
+        };
+
+        /**
+         * This is the callback scheduled by the awaiter.  It's small
+         * enough to be held inside the scheduler's callback wrapper.
+         */
+        class Wakeup {
+            // Lifecycle Methods
+        public:
+            ~Wakeup() noexcept {
+                if (awaiter_ != nullptr) {
+                    awaiter_->Drop();
+                }
+            }
+            Wakeup(const Wakeup&) = delete;
+            Wakeup(Wakeup&& other) noexcept
+                : awaiter_(other.awaiter_)
+            {
+                other.awaiter_ = nullptr;
+            }
+            Wakeup& operator=(const Wakeup&) = delete;
+            Wakeup& operator=(Wakeup&&) = delete;
+
+            /**
+             * This is the constructor of the class.
+             *
+             * @param[in] awaiter
+             *     This is the awaiter which scheduled the callback.
+             */
+            explicit Wakeup(SleepAwaiter* awaiter)
+                : awaiter_(awaiter)
+            {
+            }
+
+            // Public Methods
+        public:
+            /**
+             * Resume the coroutine, unless it's too early or too late to
+             * do so.  Once called, the callback is done with the wait, so
+             * destroying it doesn't drop the wait.
+             */
+            void operator()() {
+                const auto awaiter = awaiter_;
+                awaiter_ = nullptr;
+                awaiter->Resume();
+            }
+
+            // Private properties
+        private:
+            /**
+             * This is the awaiter which scheduled the callback, until the
+             * callback is called or moved away.
+             */
+            SleepAwaiter* awaiter_;
+        };
+
+        // Private Methods
+    private:
+        /**
+         * Resume the coroutine, unless the callback is called too early or
+         * too late to do so.  Once the state is changed, the awaiter may
+         * be destroyed at any time, so it isn't touched again.
+         */
+        void Resume() {
+            auto state = state_.load();
+            for (;;) {
+                switch (state) {
+                    case State::Suspending: {
+                        if (state_.compare_exchange_weak(state, State::FiredEarly)) {
+                            return;
+                        }
+                    } break;
+
+                    case State::Waiting: {
+                        if (state_.compare_exchange_weak(state, State::Resuming)) {
+                            coroutine_.resume();
+                            return;
+                        }
+                    } break;
+
+                    case State::Abandoned: {
+                        state_.store(State::Done, std::memory_order_release);
+                    } return;
+
+                    default: return;
+                }
+            }
+        }
+
+        /**
+         * Record that the callback was destroyed without being called,
+         * unless the wait was already over.  Once the state is changed,
+         * the awaiter may be destroyed at any time, so it isn't touched
+         * again.
+         */
+        void Drop() {
+            auto state = state_.load();
+            for (;;) {
+                switch (state) {
+                    case State::Suspending:
+                    case State::Waiting: {
+                        if (state_.compare_exchange_weak(state, State::Dropped)) {
+                            return;
+                        }
+                    } break;
+
+                    case State::Abandoned: {
+                        state_.store(State::Done, std::memory_order_release);
+                    } return;
+
+                    default: return;
+                }
+            }
+        }
+
+        // Private properties
+    private:
+        /**
+         * This is the scheduler on which to wait.
+         */
+        Scheduler* scheduler_;
+
+        /**
+         * This is the due time at which the coroutine should be resumed.
+         */
+        std::chrono::nanoseconds due_;
+
+        /**
+         * This is the token of the scheduled callback.
+         */
+        Scheduler::Token token_ = 0;
+
+        /**
+         * This is the handle of the suspended coroutine.
+         */
+        std::coroutine_handle<> coroutine_;
+
+        /**
+         * This is the stage the wait is in.
+         */
+        std::atomic< State > state_{State::Suspending};
+    };
+
+    inline SleepAwaiter Scheduler::SleepUntil(std::chrono::nanoseconds due) {
+        return SleepAwaiter(*this, due);
+    }
+
+    inline SleepAwaiter Scheduler::SleepFor(std::chrono::nanoseconds delay) {
+        const auto clock = GetClock();
+        const auto now = (
+            (clock == nullptr)
+            ? 0
+            : clock->GetCurrentTicks()
+        );
+        return SleepAwaiter(*this, std::chrono::nanoseconds(now) + delay);
+    }
+
+    /**
+     * Return an object which can be awaited by a coroutine in order to be
+     * suspended until the clock associated with the given scheduler
+     * reaches the given due time.
+     *
+     * @param[in] scheduler
+     *     This is the scheduler on which to wait.
+     *
+     * @param[in] due
+     *     This is the value that will be returned by the clock associated
+     *     with the scheduler, in ticks, at the moment when the coroutine
+     *     should be resumed.
+     *
+     * @return
+     *     The object to await is returned.
+     */
+    inline SleepAwaiter SleepUntil(
+        Scheduler& scheduler,
+        std::chrono::nanoseconds due
+    ) {
+        return scheduler.SleepUntil(due);
+    }
+
+    /**
+     * Return an object which can be awaited by a coroutine in order to be
+     * suspended until the given length of time has passed, according to
+     * the clock associated with the given scheduler.
+     *
+     * @param[in] scheduler
+     *     This is the scheduler on which to wait.
+     *
+     * @param[in] delay
+     *     This is the length of time to wait, counted from when this
+     *     function is called.
+     *
+     * @return
+     *     The object to await is returned.  If the scheduler has no
+     *     clock, the coroutine isn't suspended when it awaits the object.
+     */
+    inline SleepAwaiter SleepFor(
+        Scheduler& scheduler,
+        std::chrono::nanoseconds delay
+    ) {
+        return scheduler.SleepFor(delay);
+    }
+
+}
+
+#endif /* defined(__cpp_impl_coroutine) */
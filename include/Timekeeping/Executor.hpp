@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * @file Executor.hpp
+ *
+ * This module declares the Timekeeping::Executor interface.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "UniqueFunction.hpp"
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This represents an object which can be given functions to run,
+     * such as an event loop, a pool of threads, or a fiber scheduler.
+     */
+    class Executor {
+    public:
+        // Types
+
+        /**
+         * This is the type of function which the executor can run.
+         */
+        using Task = UniqueFunction< void() >;
+
+        // Methods
+
+        /**
+         * This method runs the given function, or arranges for it to
+         * be run as soon as possible.
+         *
+         * @param[in] task
+         *     This is the function to run.
+         *
+         * @param[in] strand
+         *     If nonzero, the task should not be run until all tasks
+         *     previously given to the executor with the same strand key
+         *     have finished.  Executors which only ever run one task
+         *     at a time, in the order given, may ignore this.
+         */
+        virtual void Execute(
+            Task task,
+            uint64_t strand
+        ) = 0;
+    };
+
+}
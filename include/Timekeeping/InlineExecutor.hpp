@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * @file InlineExecutor.hpp
+ *
+ * This module declares the Timekeeping::InlineExecutor class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Executor.hpp"
+
+namespace Timekeeping {
+
+    /**
+     * This is an executor which simply runs each function immediately,
+     * on whatever thread hands it the function.
+     */
+    class InlineExecutor
+        : public Executor
+    {
+        // Public Methods
+    public:
+        // Executor
+
+        virtual void Execute(
+            Task task,
+            uint64_t strand
+        ) override;
+    };
+
+}
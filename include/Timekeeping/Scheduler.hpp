@@ -9,12 +9,24 @@
  */
 
 #include "Clock.hpp"
+#include "Executor.hpp"
+#include "Tracer.hpp"
+#include "UniqueFunction.hpp"
 
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
 
 namespace Timekeeping {
 
+    /**
+     * This is declared in Coroutines.hpp.
+     */
+    class SleepAwaiter;
+
     /**
      * This extends a clock by offering the capability of calling functions
      * scheduled in advance.
@@ -24,9 +36,495 @@ namespace Timekeeping {
     public:
         /**
          * This is the type of function which can be scheduled to be called
-         * by the scheduler.
+         * by the scheduler.  It's move-only, so callbacks may capture
+         * values which can't be copied, and small callbacks are held
+         * without allocating any memory.
+         */
+        using Callback = UniqueFunction< void() >;
+
+        /**
+         * This is the type of value returned by the scheduler to identify
+         * a scheduled callback, so that it can be canceled later.
+         *
+         * The value should be treated as opaque.  It encodes the location
+         * of the callback in the scheduler's internal table, along with a
+         * generation count which makes the token stale once the callback
+         * is called or canceled, even after the location is reused.
+         * Zero is never a valid token.
+         */
+        using Token = uint64_t;
+
+        /**
+         * These are the ways in which the due time of each call of a
+         * periodic callback can be chosen.
+         */
+        enum class PeriodicMode {
+            /**
+             * Each call is due one interval after the previous call was
+             * due, regardless of how long it took to call the callback,
+             * so calls stay on a fixed grid of due times.
+             */
+            FixedRate,
+
+            /**
+             * Each call is due one interval after the previous call
+             * returned.
+             */
+            FixedDelay,
+        };
+
+        /**
+         * These are the ways in which a fixed-rate periodic callback can
+         * make up for periods which were missed, because the callback was
+         * called late or took longer than one interval.
+         */
+        enum class CatchUp {
+            /**
+             * Call the callback once for every missed period, one call
+             * right after another, until it's caught up.
+             */
+            CallForEachPeriod,
+
+            /**
+             * Call the callback only once for all the missed periods,
+             * and then carry on at the next due time on the grid which
+             * is still in the future.
+             */
+            SkipMissedPeriods,
+        };
+
+        /**
+         * These are the ways in which the scheduler can deal with the
+         * callbacks still scheduled when it's shut down.
+         *
+         * @note
+         *     Whatever the policy, periodic callbacks are called in place,
+         *     so before dropping callbacks, shutting down waits for any
+         *     periodic callback already handed to the executor to be
+         *     called, or discarded by the executor.  An executor whose
+         *     tasks are only run by the thread shutting the scheduler
+         *     down, such as an event loop pumped by that thread, must not
+         *     be holding any of them at the time, or shutting down never
+         *     finishes.
+         */
+        enum class ShutdownPolicy {
+            /**
+             * Call none of the callbacks.
+             */
+            DropAll,
+
+            /**
+             * Call the callbacks which are already due, and none of the
+             * others.
+             */
+            RunDue,
+
+            /**
+             * Keep calling callbacks as they become due, for up to the
+             * given length of time, and then drop the rest.
+             */
+            Drain,
+        };
+
+        /**
+         * This holds a callback to be scheduled, along with the details
+         * of when and how it should be called.
          */
-        using Callback = std::function< void() >;
+        struct ScheduleRequest {
+            /**
+             * This is the function to call when the callback is due.
+             */
+            Callback callback;
+
+            /**
+             * This is the value that will be returned by the associated
+             * clock's GetCurrentTicks method at the moment when the callback
+             * function should be called.
+             */
+            std::chrono::nanoseconds due{0};
+
+            /**
+             * This is passed to the executor which calls the callback.
+             * Callbacks with the same nonzero strand key are called one
+             * at a time, in the order they become due, while callbacks
+             * with a strand key of zero may be called in parallel with any
+             * other callbacks, if the executor runs more than one function
+             * at a time.
+             */
+            uint64_t strand = 0;
+
+            /**
+             * This is how much later than the due time the callback may be
+             * called.  Callbacks with slack are moved later, to the next
+             * multiple of the largest power of two number of ticks which
+             * isn't more than the slack, so that callbacks due around the
+             * same time are called together, in one wake-up of the worker
+             * thread.  Callbacks with no slack are called as close to their
+             * due times as possible.
+             */
+            std::chrono::nanoseconds slack{0};
+
+            /**
+             * If nonzero, the callback is periodic, and this is the length
+             * of time between calls.  The callback stays scheduled, with
+             * the same token, until canceled.
+             */
+            std::chrono::nanoseconds interval{0};
+
+            /**
+             * This selects how the due time of each call of a periodic
+             * callback is chosen.
+             */
+            PeriodicMode periodicMode = PeriodicMode::FixedRate;
+
+            /**
+             * This selects how a fixed-rate periodic callback makes up for
+             * missed periods.
+             */
+            CatchUp catchUp = CatchUp::SkipMissedPeriods;
+
+            /**
+             * This optionally names the place in the program which
+             * scheduled the callback, such as a function name, or a file
+             * name and line number, so that it can be given when reporting
+             * a problem with the callback.  It must point to a string
+             * which outlives the callback, such as a string literal.
+             */
+            const char* site = nullptr;
+
+            /**
+             * If nonzero, this identifies the kind of callback, so that
+             * it's included in snapshots of the scheduler, and can be made
+             * again when restored from a snapshot, by the callback factory
+             * registered for this type.  Callbacks with a type of zero
+             * aren't included in snapshots.
+             */
+            uint32_t type = 0;
+
+            /**
+             * This is kept along with the callback in snapshots, and given
+             * to the callback factory when the callback is restored, so
+             * that it can tell which callback to make, such as by naming
+             * the session whose timeout the callback handles.
+             */
+            uint64_t key = 0;
+        };
+
+        /**
+         * This is the type of function which makes callbacks of one type
+         * again when they're restored from a snapshot.
+         *
+         * @param[in] key
+         *     This is the key given when the callback was scheduled.
+         *
+         * @return
+         *     The callback to schedule is returned, or nullptr if the
+         *     callback shouldn't be restored.
+         */
+        using CallbackFactory = std::function< Callback(uint64_t key) >;
+
+        /**
+         * This tells which token was given to a callback restored from
+         * a snapshot.
+         */
+        struct RestoredCallback {
+            /**
+             * This is the key given when the callback was scheduled.
+             */
+            uint64_t key = 0;
+
+            /**
+             * This is the token of the restored callback.
+             */
+            Token token = 0;
+        };
+
+        /**
+         * This is the type of function the scheduler calls to report a
+         * problem with a callback.
+         *
+         * @param[in] token
+         *     This identifies the callback, as returned when it was
+         *     scheduled, or is zero if the problem isn't with a callback.
+         *
+         * @param[in] site
+         *     This is the place in the program which scheduled the
+         *     callback, if it was given.
+         *
+         * @param[in] duration
+         *     This is how long the problem had lasted when reported.
+         */
+        using ProblemReporter = std::function<
+            void(
+                Token token,
+                const char* site,
+                std::chrono::nanoseconds duration
+            )
+        >;
+
+        /**
+         * These are the different data structures the scheduler can use
+         * to hold scheduled callbacks until they become due.
+         */
+        enum class Backend {
+            /**
+             * Hold scheduled callbacks in a heap.  Scheduling and
+             * calling a callback take logarithmic time, and callbacks
+             * are called in the exact order of their due times.  Callbacks
+             * due at the same time are called in the order they were
+             * scheduled, among those scheduled into the same shard.
+             */
+            Heap,
+
+            /**
+             * Hold scheduled callbacks in a hierarchical timing wheel.
+             * Scheduling a callback takes constant time, but due times
+             * are rounded up to the next tick of the wheel, and callbacks
+             * due in the same tick are called in no particular order.
+             */
+            TimingWheel,
+        };
+
+        /**
+         * This holds the settings which are selected when the scheduler
+         * is constructed, and which can't be changed afterwards.
+         */
+        struct Configuration {
+            /**
+             * This selects the data structure the scheduler uses to hold
+             * scheduled callbacks until they become due.
+             */
+            Backend backend = Backend::Heap;
+
+            /**
+             * This is the length of one tick of the timing wheel, in the
+             * same units (typically seconds) as the scheduler's clock.
+             * It's only used by the timing wheel backend.
+             */
+            double tickResolution = 0.001;
+
+            /**
+             * This is the maximum number of due callbacks which the worker
+             * thread takes from the queue at once.  The worker samples the
+             * clock once, takes every callback due by that time (up to
+             * this limit) under a single lock, and then calls them all
+             * without holding the lock.
+             *
+             * Larger batches save lock handoffs and clock readings when
+             * many callbacks become due together, but delay any callbacks
+             * which become due while a batch is running, and make it
+             * more likely that a callback canceled by another callback in
+             * the same batch is called anyway.
+             */
+            size_t maxBatchSize = 1;
+
+            /**
+             * This is the number of independently locked portions ("shards")
+             * into which the scheduler divides its scheduled callbacks,
+             * up to a maximum of 256.  Each thread which schedules
+             * callbacks is assigned one shard, so that threads scheduling
+             * callbacks at the same time rarely contend for the same lock.
+             * The worker thread takes due callbacks from every shard,
+             * calling them in the order they became due.  The batch size
+             * limit applies to each shard separately.
+             */
+            size_t shards = 1;
+
+            /**
+             * If set, Schedule and Cancel don't take any lock or touch
+             * the data structure holding scheduled callbacks.  Instead they
+             * push the callback onto a lock-free list, which the worker
+             * thread empties into the data structure whenever it wakes up.
+             * This keeps the cost to threads scheduling callbacks down to
+             * a few atomic operations, at the price of canceled callbacks
+             * being destroyed by the worker thread a little while later,
+             * rather than before Cancel returns.
+             */
+            bool lockFreeSubmission = false;
+
+            /**
+             * If set, the worker thread waits for the next callback to
+             * become due until an absolute deadline on the system's steady
+             * clock, at its full resolution, rather than for a whole number
+             * of milliseconds.  This assumes the scheduler's clock counts
+             * seconds.
+             */
+            bool preciseWaiting = false;
+
+            /**
+             * This is only used in precise waiting mode.  It's the length
+             * of time, in seconds (up to one second), before the next
+             * callback is due, during which the worker thread spins on the
+             * processor rather than sleeping, so that it isn't late waking
+             * up.  Spinning keeps one processor busy, so this should be
+             * just long enough to cover the operating system's wake-up
+             * latency, typically some tens of microseconds.
+             */
+            double spinTime = 0.0;
+
+            /**
+             * This is the object to which the scheduler's worker thread
+             * hands callbacks once they become due, so that they can be
+             * called on an event loop or thread pool owned by the user.
+             * If null, the scheduler provides its own executor, according
+             * to the callbackThreads setting.
+             */
+            std::shared_ptr< Executor > executor;
+
+            /**
+             * This is only used if no executor is given.  It's the number
+             * of threads to start in a pool used to call callbacks once they
+             * become due.  If zero, callbacks are called directly by the
+             * scheduler's own worker thread, and so one slow callback delays
+             * any others which become due.
+             */
+            size_t callbackThreads = 0;
+
+            /**
+             * If true, the scheduler doesn't start a worker thread of its
+             * own.  Instead, its owner calls GetNextDeadline to find out
+             * when the next callback is due, and RunDue to call the
+             * callbacks which are due, typically from an event loop it
+             * already has.  The precise waiting settings don't apply
+             * in this mode.
+             */
+            bool threadless = false;
+
+            /**
+             * In threadless mode, this is called, if set, when a callback
+             * is scheduled which may be due sooner than the deadline last
+             * returned by GetNextDeadline, so that the owner can cut short
+             * its wait, for example by writing to an eventfd.  It's called
+             * by whichever thread schedules the callback, so it shouldn't
+             * do much, and mustn't use the scheduler.
+             */
+            std::function< void() > deadlineChanged;
+
+            /**
+             * If true, in threadless mode, the scheduler provides a file
+             * descriptor, returned by GetPollDescriptor, which becomes
+             * readable when the deadline last returned by GetNextDeadline
+             * is reached, or when a callback is scheduled which may be due
+             * sooner.  This lets the owner wait for the scheduler along
+             * with its other file descriptors, in one system call.  It's
+             * only available on Linux.
+             */
+            bool pollable = false;
+
+            /**
+             * If true, the scheduler measures how long it takes to hand
+             * each due callback to the executor, which, when callbacks
+             * are called directly by the scheduler, is how long each
+             * callback takes to run.  This reads the system's steady
+             * clock twice for every callback, so it's off by default.
+             */
+            bool measureCallbackTime = false;
+
+            /**
+             * If greater than zero, this is the length of time, in
+             * seconds, beyond which the scheduler reports, through the
+             * slowCallback function, any callback it takes longer than
+             * that to hand to the executor.  When callbacks are called
+             * directly by the scheduler, that's how long the callback
+             * takes to run, which is also how long every other callback
+             * is held up.
+             */
+            double slowCallbackThreshold = 0.0;
+
+            /**
+             * This is called, if set, by the thread which called a
+             * callback that took longer than the slowCallbackThreshold,
+             * once the callback returns.
+             */
+            ProblemReporter slowCallback;
+
+            /**
+             * If greater than zero, and workerStalled is set, the
+             * scheduler starts a second thread which watches the worker
+             * thread, and reports through the workerStalled function if
+             * the worker spends longer than this length of time, in
+             * seconds, in one callback, or fails to wake up for this
+             * long after the next callback became due.  It isn't used
+             * in threadless mode.
+             */
+            double watchdogTimeout = 0.0;
+
+            /**
+             * This is called, if set, by the watchdog thread, once for
+             * each stall of the worker thread it finds.  If the worker is
+             * stuck in a callback, that callback is identified, and the
+             * callback may still be running at the time.
+             */
+            ProblemReporter workerStalled;
+
+            /**
+             * This is the object told about callbacks as they're scheduled,
+             * canceled, and called, if the library was built with the
+             * TIMEKEEPING_TRACING option.  Otherwise it's ignored.
+             */
+            std::shared_ptr< Tracer > tracer;
+        };
+
+        /**
+         * This holds counts of things the scheduler has done, which
+         * can be used to see how efficiently it's working.
+         */
+        struct Statistics {
+            /**
+             * This is the number of times the worker thread has woken up
+             * after waiting, either because its wait timed out, or because
+             * it was told that something changed.
+             */
+            uint64_t wakeUps = 0;
+
+            /**
+             * This is the number of wake-ups of the worker thread after
+             * which it found at least one callback due to be called.
+             */
+            uint64_t usefulWakeUps = 0;
+
+            /**
+             * This is the number of callbacks which have been scheduled,
+             * and not yet called or canceled.  Periodic callbacks stay
+             * pending until they're canceled.
+             */
+            uint64_t pending = 0;
+
+            /**
+             * This is the number of callbacks which have been canceled,
+             * but whose slots haven't been reclaimed yet, for example
+             * because in lock-free submission mode the worker thread
+             * hasn't caught up with the cancellation.
+             */
+            uint64_t canceledUnreclaimed = 0;
+
+            /**
+             * This is the number of times a due callback has been handed
+             * to the executor to be called.
+             */
+            uint64_t fired = 0;
+
+            /**
+             * These describe how late callbacks have been handed to the
+             * executor, compared to when they were due (once any slack was
+             * applied), as measured by the scheduler's clock when it took
+             * them from the queue.  The median and 99th percentile are
+             * rounded up to one less than a power of two nanoseconds.
+             */
+            std::chrono::nanoseconds medianLateness{0};
+            std::chrono::nanoseconds lateness99th{0};
+            std::chrono::nanoseconds maxLateness{0};
+
+            /**
+             * These describe how long it took to hand each due callback
+             * to the executor, rounded in the same way as the lateness.
+             * They're only measured if the measureCallbackTime setting
+             * is selected.
+             */
+            std::chrono::nanoseconds medianCallbackTime{0};
+            std::chrono::nanoseconds callbackTime99th{0};
+            std::chrono::nanoseconds maxCallbackTime{0};
+        };
 
         // Lifecycle Methods
     public:
@@ -39,10 +537,19 @@ namespace Timekeeping {
         // Public Methods
     public:
         /**
-         * This is the constructor of the class.
+         * This is the default constructor of the class, which sets up
+         * the scheduler with the default configuration.
          */
         Scheduler();
 
+        /**
+         * This constructs the scheduler with the given configuration.
+         *
+         * @param[in] configuration
+         *     This holds the settings to use for the scheduler.
+         */
+        explicit Scheduler(const Configuration& configuration);
+
         /**
          * Return the clock object used to know when to call scheduled
          * callbacks.
@@ -55,6 +562,8 @@ namespace Timekeeping {
 
         /**
          * Set the clock object used to know when to call scheduled callbacks.
+         * Until this is called, the scheduler uses a SteadyClock.  If it's
+         * set to null, callbacks can't be scheduled.
          *
          * @param[in] clock
          *     This is the object used to know when to call scheduled
@@ -75,13 +584,251 @@ namespace Timekeeping {
          *     This is the value that will be returned by the associated clock
          *     at the moment when the callback function should be called.
          *
+         * @param[in] slack
+         *     This is how many seconds later than the due time the
+         *     callback may be called, so that its call can share a wake-up
+         *     of the worker thread with other callbacks.  Zero means the
+         *     callback is called as close to the due time as possible.
+         *
          * @return
          *     A token is returned, which may be used to cancel the callback
          *     call before the due time.
          */
-        int Schedule(
+        Token Schedule(
             Callback callback,
-            double due
+            double due,
+            double slack = 0.0
+        );
+
+        /**
+         * Schedule the given callback function to be called when the
+         * time returned, in ticks, by the clock associated with the
+         * scheduler reaches the given due time.
+         *
+         * @param[in] callback
+         *     This is the function to call later (or immediately, if the
+         *     due time is now or in the past).
+         *
+         * @param[in] due
+         *     This is the value that will be returned by the associated
+         *     clock's GetCurrentTicks method at the moment when the callback
+         *     function should be called.
+         *
+         * @param[in] slack
+         *     This is how much later than the due time the callback may be
+         *     called, so that its call can share a wake-up of the worker
+         *     thread with other callbacks.  Zero means the callback is
+         *     called as close to the due time as possible.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the callback
+         *     call before the due time.
+         */
+        Token Schedule(
+            Callback callback,
+            std::chrono::nanoseconds due,
+            std::chrono::nanoseconds slack = std::chrono::nanoseconds(0)
+        );
+
+        /**
+         * Schedule the given callback function to be called at the given
+         * time point.  This assumes that the clock associated with the
+         * scheduler has the same reference point as the clock of the
+         * time point.
+         *
+         * @param[in] callback
+         *     This is the function to call later (or immediately, if the
+         *     due time is now or in the past).
+         *
+         * @param[in] due
+         *     This is the time point at which the callback function
+         *     should be called.
+         *
+         * @param[in] slack
+         *     This is how much later than the due time the callback may be
+         *     called, so that its call can share a wake-up of the worker
+         *     thread with other callbacks.  Zero means the callback is
+         *     called as close to the due time as possible.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the callback
+         *     call before the due time.
+         */
+        template< typename ChronoClock, typename ChronoDuration > Token Schedule(
+            Callback callback,
+            std::chrono::time_point< ChronoClock, ChronoDuration > due,
+            std::chrono::nanoseconds slack = std::chrono::nanoseconds(0)
+        ) {
+            return Schedule(
+                std::move(callback),
+                std::chrono::duration_cast< std::chrono::nanoseconds >(
+                    due.time_since_epoch()
+                ),
+                slack
+            );
+        }
+
+        /**
+         * Schedule the given callback function to be called once the
+         * given length of time has passed, according to the clock
+         * associated with the scheduler.
+         *
+         * @param[in] callback
+         *     This is the function to call later.
+         *
+         * @param[in] delay
+         *     This is the length of time to wait before calling the
+         *     callback function.
+         *
+         * @param[in] slack
+         *     This is how much later than the due time the callback may be
+         *     called, so that its call can share a wake-up of the worker
+         *     thread with other callbacks.  Zero means the callback is
+         *     called as close to the due time as possible.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the callback
+         *     call before the due time.
+         */
+        Token ScheduleAfter(
+            Callback callback,
+            std::chrono::nanoseconds delay,
+            std::chrono::nanoseconds slack = std::chrono::nanoseconds(0)
+        );
+
+        /**
+         * Return an object which can be awaited by a coroutine in order to
+         * be suspended until the clock associated with the scheduler
+         * reaches the given due time.
+         *
+         * @note
+         *     This is defined in Coroutines.hpp, which must be included in
+         *     order to use it, and is only available when compiling with
+         *     coroutine support.
+         *
+         * @param[in] due
+         *     This is the value that will be returned by the clock
+         *     associated with the scheduler, in ticks, at the moment when
+         *     the coroutine should be resumed.
+         *
+         * @return
+         *     The object to await is returned.
+         */
+        SleepAwaiter SleepUntil(std::chrono::nanoseconds due);
+
+        /**
+         * Return an object which can be awaited by a coroutine in order to
+         * be suspended until the given length of time has passed,
+         * according to the clock associated with the scheduler.
+         *
+         * @note
+         *     This is defined in Coroutines.hpp, which must be included in
+         *     order to use it, and is only available when compiling with
+         *     coroutine support.
+         *
+         * @param[in] delay
+         *     This is the length of time to wait, counted from when this
+         *     method is called.
+         *
+         * @return
+         *     The object to await is returned.  If the scheduler has no
+         *     clock, the coroutine isn't suspended when it awaits the
+         *     object.
+         */
+        SleepAwaiter SleepFor(std::chrono::nanoseconds delay);
+
+        /**
+         * Schedule a callback function as described by the given request.
+         *
+         * @param[in] request
+         *     This holds the callback function to schedule, along with the
+         *     details of when and how it should be called.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the callback
+         *     call before the due time.
+         */
+        Token Schedule(ScheduleRequest request);
+
+        /**
+         * Schedule the given callback function to be called periodically,
+         * starting at the given due time, until canceled.
+         *
+         * The same entry, callback object, and token are used for every
+         * call, so no memory is allocated after the first.  Each call is
+         * scheduled only once the previous call returns, so calls never
+         * overlap.
+         *
+         * @note
+         *     The callback is called through a task which refers back to
+         *     the scheduler, so a user-provided executor must run or
+         *     discard all of its tasks before the scheduler is destroyed.
+         *
+         * @param[in] callback
+         *     This is the function to call periodically.
+         *
+         * @param[in] firstDue
+         *     This is the value that will be returned by the associated
+         *     clock's GetCurrentTicks method at the moment when the callback
+         *     function should first be called.
+         *
+         * @param[in] interval
+         *     This is the length of time between calls.  It must be
+         *     greater than zero.
+         *
+         * @param[in] periodicMode
+         *     This selects how the due time of each call is chosen.
+         *
+         * @param[in] catchUp
+         *     This selects how missed periods are made up for, in
+         *     fixed-rate mode.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the periodic
+         *     callback.  Zero is returned if the interval isn't greater
+         *     than zero.
+         */
+        Token SchedulePeriodic(
+            Callback callback,
+            std::chrono::nanoseconds firstDue,
+            std::chrono::nanoseconds interval,
+            PeriodicMode periodicMode = PeriodicMode::FixedRate,
+            CatchUp catchUp = CatchUp::SkipMissedPeriods
+        );
+
+        /**
+         * Schedule the given callback function to be called periodically,
+         * starting at the given due time, until canceled.  This is the
+         * same as the other overload, but with times in seconds.
+         *
+         * @param[in] callback
+         *     This is the function to call periodically.
+         *
+         * @param[in] firstDue
+         *     This is the value that will be returned by the associated
+         *     clock at the moment when the callback function should first
+         *     be called.
+         *
+         * @param[in] interval
+         *     This is the length of time between calls, in seconds.
+         *
+         * @param[in] periodicMode
+         *     This selects how the due time of each call is chosen.
+         *
+         * @param[in] catchUp
+         *     This selects how missed periods are made up for, in
+         *     fixed-rate mode.
+         *
+         * @return
+         *     A token is returned, which may be used to cancel the periodic
+         *     callback.
+         */
+        Token SchedulePeriodic(
+            Callback callback,
+            double firstDue,
+            double interval,
+            PeriodicMode periodicMode = PeriodicMode::FixedRate,
+            CatchUp catchUp = CatchUp::SkipMissedPeriods
         );
 
         /**
@@ -89,14 +836,329 @@ namespace Timekeeping {
          *
          * @note
          *     The callback may be called anyway, if canceled close to the
-         *     due time.
+         *     due time.  A canceled callback which isn't periodic is
+         *     destroyed before this method returns.  In lock-free
+         *     submission mode, a canceled periodic callback is destroyed
+         *     by the worker thread, after this method returns.  A periodic
+         *     callback canceled while it's being called is destroyed once
+         *     the call returns.
          *
          * @param[in] token
          *     This represents the scheduled callback to be canceled.  It was
          *     provided by the `Schedule` method when the callback was
          *     scheduled.
+         *
+         * @return
+         *     An indication of whether or not the callback was still
+         *     scheduled, and so won't be called (again), is returned.
+         *     If not, the callback was already handed to the executor,
+         *     or canceled, or the token is stale.
+         */
+        bool Cancel(Token token);
+
+        /**
+         * Change when the scheduled callback corresponding to the given
+         * token should be called, keeping the same token.
+         *
+         * Moving a callback later only records the new due time, and the
+         * callback is moved once its old due time comes, so that pushing
+         * back a deadline, such as an idle timeout, over and over again
+         * costs little more than taking the lock.
+         *
+         * @note
+         *     The callback may be called at its old due time anyway, if
+         *     rescheduled close to it.  For a periodic callback, this
+         *     changes when the next call is due, and later calls follow
+         *     on from it.
+         *
+         * @param[in] token
+         *     This represents the scheduled callback to be rescheduled.
+         *     It was provided by the `Schedule` method when the callback
+         *     was scheduled.
+         *
+         * @param[in] due
+         *     This is the value that will be returned by the associated
+         *     clock's GetCurrentTicks method at the moment when the callback
+         *     function should now be called.
+         *
+         * @return
+         *     An indication of whether or not the callback was still
+         *     scheduled, and so was rescheduled, is returned.
+         */
+        bool Reschedule(
+            Token token,
+            std::chrono::nanoseconds due
+        );
+
+        /**
+         * Change when the scheduled callback corresponding to the given
+         * token should be called, keeping the same token.  This is the
+         * same as the other overload, but with the due time in seconds.
+         *
+         * @param[in] token
+         *     This represents the scheduled callback to be rescheduled.
+         *
+         * @param[in] due
+         *     This is the value that will be returned by the associated
+         *     clock at the moment when the callback function should now
+         *     be called.
+         *
+         * @return
+         *     An indication of whether or not the callback was still
+         *     scheduled, and so was rescheduled, is returned.
+         */
+        bool Reschedule(
+            Token token,
+            double due
+        );
+
+        /**
+         * Change the scheduled callback corresponding to the given token
+         * to be called once the given length of time has passed, from
+         * the current time of the associated clock.
+         *
+         * @param[in] token
+         *     This represents the scheduled callback to be rescheduled.
+         *
+         * @param[in] delay
+         *     This is how long from now the callback should be called.
+         *
+         * @return
+         *     An indication of whether or not the callback was still
+         *     scheduled, and so was rescheduled, is returned.
+         */
+        bool RescheduleAfter(
+            Token token,
+            std::chrono::nanoseconds delay
+        );
+
+        /**
+         * Schedule all the given callback functions at once.  This is
+         * equivalent to calling Schedule for each of them, except that it's
+         * done as a single operation which the worker thread is woken up
+         * for at most once.
+         *
+         * @param[in] requests
+         *     These are the callback functions to schedule, along with
+         *     their due times.
+         *
+         * @return
+         *     The tokens for the scheduled callbacks are returned, in the
+         *     same order as the given requests.
+         */
+        std::vector< Token > ScheduleMany(std::vector< ScheduleRequest > requests);
+
+        /**
+         * Set the function used to make callbacks of the given type
+         * again when they're restored from a snapshot.
+         *
+         * @param[in] type
+         *     This is the type of callback the factory makes.  It must
+         *     not be zero.
+         *
+         * @param[in] factory
+         *     This is the function which makes callbacks of the given
+         *     type.  If nullptr, callbacks of this type aren't restored.
+         */
+        void RegisterCallbackFactory(
+            uint32_t type,
+            CallbackFactory factory
+        );
+
+        /**
+         * Return a compact binary record of the callbacks scheduled now
+         * which were given a nonzero type, holding each callback's type,
+         * key, due time, slack, strand, and periodic details, but not the
+         * callback itself.  It can be written to a file and given to
+         * Restore in a later run of the program, even through a memory
+         * mapping of the file, to schedule the callbacks again.
+         *
+         * @note
+         *     Due times are kept in ticks of the scheduler's clock, so
+         *     they only mean the same thing when restored if the clock
+         *     has the same reference point, such as the system's
+         *     monotonic clock between runs of the program since the
+         *     system started.
+         *
+         * @return
+         *     The snapshot of the scheduled callbacks is returned.
+         */
+        std::vector< uint8_t > Snapshot() const;
+
+        /**
+         * Schedule again the callbacks recorded in the given snapshot,
+         * made by the callback factories registered for their types,
+         * all in one batch, as done by ScheduleMany.  Callbacks of types
+         * with no registered factory, or for which the factory returns
+         * nullptr, are skipped.
+         *
+         * @param[in] snapshot
+         *     This points to the snapshot, as returned by Snapshot.
+         *
+         * @param[in] size
+         *     This is the number of bytes in the snapshot.
+         *
+         * @return
+         *     The keys and new tokens of the restored callbacks are
+         *     returned, in the order they're recorded in the snapshot.
+         *     A token is zero if its callback couldn't be scheduled.
+         *     Nothing is returned if the snapshot isn't valid.
+         */
+        std::vector< RestoredCallback > Restore(
+            const void* snapshot,
+            size_t size
+        );
+
+        /**
+         * Terminate all the scheduled callbacks corresponding to the given
+         * tokens.  This is equivalent to calling Cancel for each of them,
+         * except that it's done as a single operation.
+         *
+         * @param[in] tokens
+         *     These represent the scheduled callbacks to be canceled.
+         */
+        void CancelMany(const std::vector< Token >& tokens);
+
+        /**
+         * Make room in each shard of the scheduler for at least the given
+         * number of callbacks to be scheduled at once, so that scheduling
+         * that many doesn't need to allocate memory, other than for any
+         * callbacks too big to be held inside their Callback wrappers.
+         *
+         * @param[in] callbacks
+         *     This is the number of callbacks for which to make room
+         *     in each shard.
+         */
+        void Reserve(size_t callbacks);
+
+        /**
+         * Release memory the scheduler is holding onto for callbacks
+         * beyond those scheduled now, such as after a burst of many
+         * callbacks has been called or canceled.
+         *
+         * @note
+         *     In lock-free submission mode, callbacks are given their
+         *     slots without taking any lock, so only the spare capacity
+         *     of the timer queues is released, and the slots are kept.
+         */
+        void ShrinkToFit();
+
+        /**
+         * Stop the scheduler, dealing with the callbacks still scheduled
+         * according to the given policy.  Callbacks are called on the
+         * thread calling this method, through the executor, and the
+         * worker thread is stopped first.  The callbacks which aren't
+         * called are then dropped all at once, releasing the memory held
+         * for them in bulk rather than one callback at a time.
+         *
+         * Afterwards, the scheduler doesn't schedule any more callbacks,
+         * including any scheduled by the callbacks called while shutting
+         * down, and returns zero tokens for them.
+         *
+         * @note
+         *     Periodic callbacks are called at most once more, if they're
+         *     due, and then dropped.
+         *
+         * @note
+         *     This must not be called from a callback, or while other
+         *     threads are using the scheduler, other than callbacks still
+         *     being called by the executor.  In threadless mode, it must
+         *     not be called at the same time as RunDue.
+         *
+         * @note
+         *     For a scheduler of a timer service, the service keeps
+         *     running, so only the callbacks scheduled through this
+         *     scheduler are dropped, regardless of the policy.
+         *
+         * @param[in] policy
+         *     This selects what to do with the callbacks still scheduled.
+         *
+         * @param[in] drainTime
+         *     This is how long to keep calling callbacks as they become
+         *     due, with the Drain policy.  Draining ends early once no
+         *     callbacks are due before this time has passed.
+         *
+         * @return
+         *     The number of callbacks dropped without being called is
+         *     returned.
+         */
+        size_t Shutdown(
+            ShutdownPolicy policy,
+            std::chrono::nanoseconds drainTime = std::chrono::nanoseconds(0)
+        );
+
+        /**
+         * Return counts of things the scheduler has done so far.
+         *
+         * @note
+         *     The counts are kept separately, without any locking, and
+         *     only gathered together here, so while the scheduler is
+         *     busy they may be slightly out of step with each other.
+         *
+         * @return
+         *     Counts of things the scheduler has done so far are returned.
+         */
+        Statistics GetStatistics() const;
+
+        /**
+         * In threadless mode, return when the next scheduled callback is
+         * due, so that the owner of the scheduler knows when to call
+         * RunDue.  Only one thread at a time may call this method or
+         * RunDue.
+         *
+         * @return
+         *     The value that will be returned by the associated clock's
+         *     GetCurrentTicks method when the next scheduled callback is
+         *     due is returned.  If no callbacks are scheduled, the largest
+         *     possible value is returned.
          */
-        void Cancel(int token);
+        std::chrono::nanoseconds GetNextDeadline();
+
+        /**
+         * In threadless mode, call the callbacks which are due at the given
+         * time, up to the maximum batch size from each shard.  Only one
+         * thread at a time may call this method or GetNextDeadline.
+         *
+         * @param[in] now
+         *     This is the current time, as returned by the associated
+         *     clock's GetCurrentTicks method.
+         *
+         * @return
+         *     The number of callbacks handed to the executor is returned.
+         *     If this is the maximum batch size for any shard, more
+         *     callbacks may already be due.
+         */
+        size_t RunDue(std::chrono::nanoseconds now);
+
+        /**
+         * In threadless mode, call the callbacks which are due at the
+         * current time of the associated clock, up to the maximum batch
+         * size from each shard.  Only one thread at a time may call this
+         * method or GetNextDeadline.
+         *
+         * @return
+         *     The number of callbacks handed to the executor is returned.
+         */
+        size_t RunDue();
+
+        /**
+         * In threadless mode, if the scheduler was configured to be
+         * pollable, return a file descriptor which becomes readable when
+         * the deadline last returned by GetNextDeadline is reached, or when
+         * a callback is scheduled which may be due sooner.  The descriptor
+         * stays readable until GetNextDeadline is called again.  It belongs
+         * to the scheduler, and must not be read from or closed.
+         *
+         * @note
+         *     The descriptor is timed by the system's monotonic clock,
+         *     from the moment GetNextDeadline is called, so it's only
+         *     accurate if the scheduler's clock moves at the same rate.
+         *
+         * @return
+         *     The file descriptor to poll is returned, or -1 if there
+         *     isn't one.
+         */
+        int GetPollDescriptor() const;
 
         // --------------------------------------------------------------------
         // All methods in this section are for testing only and should not
@@ -117,8 +1179,10 @@ namespace Timekeeping {
         // be used outside of the test framework.
         // --------------------------------------------------------------------
 
-        // Private properties
+        // Private Methods
     private:
+        friend class TimerService;
+
         /**
          * This is the type of structure that contains the private
          * properties of the instance.  It is defined in the implementation
@@ -127,9 +1191,49 @@ namespace Timekeeping {
         struct Impl;
 
         /**
-         * This contains the private properties of the instance.
+         * This is the type of structure which keeps track of the callbacks
+         * scheduled through one of the schedulers sharing a timer service.
+         * It is defined in the implementation and declared here to ensure
+         * that it is scoped inside the class.
+         */
+        struct Handle;
+
+        /**
+         * This constructs a scheduler which shares the given private
+         * properties with other schedulers.
+         *
+         * @param[in] impl
+         *     These are the private properties to share.
+         *
+         * @param[in] tracked
+         *     This indicates whether or not the scheduler should keep
+         *     track of the callbacks scheduled through it, and cancel
+         *     them when it's destroyed.
+         */
+        Scheduler(
+            std::shared_ptr< Impl > impl,
+            bool tracked
+        );
+
+        /**
+         * If the scheduler keeps track of the callbacks scheduled through
+         * it, cancel all of them.
+         */
+        void CancelTrackedCallbacks();
+
+        // Private properties
+    private:
+        /**
+         * This contains the private properties of the instance.  They're
+         * shared by all the schedulers made by the same timer service.
+         */
+        std::shared_ptr< Impl > impl_;
+
+        /**
+         * If the scheduler was made by a timer service, this keeps track
+         * of the callbacks scheduled through it.
          */
-        std::unique_ptr< Impl > impl_;
+        std::shared_ptr< Handle > handle_;
     };
 
 }
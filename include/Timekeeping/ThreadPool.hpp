@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file ThreadPool.hpp
+ *
+ * This module declares the Timekeeping::ThreadPool class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Executor.hpp"
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This is a fixed set of threads which run tasks handed to them.
+     * Each thread has its own queue of tasks, and threads which run out
+     * of tasks steal them from the queues of other threads.
+     *
+     * Tasks may be given a "strand" key.  Tasks with the same nonzero
+     * strand key are run one at a time, in the order they were posted,
+     * while all other tasks may run in parallel and in any order.
+     */
+    class ThreadPool
+        : public Executor
+    {
+        // Lifecycle Methods
+    public:
+        /**
+         * This is the destructor of the class.  It waits for all tasks
+         * already posted to be run before returning.
+         */
+        ~ThreadPool() noexcept;
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) noexcept;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ThreadPool& operator=(ThreadPool&&) noexcept;
+
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         *
+         * @param[in] threads
+         *     This is the number of threads to start.  At least one
+         *     thread is always started.
+         */
+        explicit ThreadPool(size_t threads);
+
+        /**
+         * Hand the given task to the pool to be run as soon as possible.
+         *
+         * @param[in] task
+         *     This is the function to run.
+         *
+         * @param[in] strand
+         *     If nonzero, the task is not run until all previously posted
+         *     tasks with the same strand key have finished.
+         */
+        void Post(
+            Task task,
+            uint64_t strand = 0
+        );
+
+        // Executor
+
+        virtual void Execute(
+            Task task,
+            uint64_t strand
+        ) override;
+
+        // Private properties
+    private:
+        /**
+         * This is the type of structure that contains the private
+         * properties of the instance.  It is defined in the implementation
+         * and declared here to ensure that it is scoped inside the class.
+         */
+        struct Impl;
+
+        /**
+         * This contains the private properties of the instance.
+         */
+        std::unique_ptr< Impl > impl_;
+    };
+
+}
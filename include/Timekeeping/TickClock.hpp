@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * @file TickClock.hpp
+ *
+ * This module declares the Timekeeping::TickClock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Clock.hpp"
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This is a base for clocks which count time natively in integer
+     * ticks.  Such clocks only need to provide GetCurrentTicks, and get
+     * GetCurrentTime as an adapter on top of it.
+     */
+    class TickClock
+        : public Clock
+    {
+    public:
+        // Methods
+
+        // Clock
+
+        virtual int64_t GetCurrentTicks() override = 0;
+        virtual double GetCurrentTime() override;
+    };
+
+}
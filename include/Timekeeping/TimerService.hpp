@@ -0,0 +1,75 @@
+#pragma once
+
+/**
+ * @file TimerService.hpp
+ *
+ * This module declares the Timekeeping::TimerService class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "Scheduler.hpp"
+
+namespace Timekeeping {
+
+    /**
+     * This is a single timer engine, with its own worker thread (or none,
+     * in threadless mode), timer queues, clock, and executor, which can
+     * be shared by any number of schedulers.
+     *
+     * Each scheduler made by the service keeps track of the callbacks
+     * scheduled through it.  It can only cancel or reschedule those
+     * callbacks, and cancels any of them which are still scheduled when
+     * it's destroyed, so that sharing the engine doesn't change how any
+     * one scheduler behaves.  The engine itself is destroyed once the
+     * service and all the schedulers it made have been destroyed.
+     */
+    class TimerService {
+        // Lifecycle Methods
+    public:
+        ~TimerService() noexcept;
+        TimerService(const TimerService&) = delete;
+        TimerService(TimerService&&) noexcept;
+        TimerService& operator=(const TimerService&) = delete;
+        TimerService& operator=(TimerService&&) noexcept;
+
+        // Public Methods
+    public:
+        /**
+         * This is the default constructor of the class, which sets up
+         * the engine with the default configuration.
+         */
+        TimerService();
+
+        /**
+         * This constructs the service, with its engine set up using the
+         * given configuration.
+         *
+         * @param[in] configuration
+         *     This holds the settings to use for the engine.
+         */
+        explicit TimerService(const Scheduler::Configuration& configuration);
+
+        /**
+         * Make a new scheduler which uses the engine of the service.
+         *
+         * @note
+         *     The clock and statistics of the engine are shared, so
+         *     setting the clock of any one scheduler made by the service
+         *     sets it for all of them.
+         *
+         * @return
+         *     The new scheduler is returned.
+         */
+        Scheduler MakeScheduler();
+
+        // Private properties
+    private:
+        /**
+         * This is the scheduler which owns the engine of the service.
+         * Callbacks aren't scheduled through it directly.
+         */
+        Scheduler engine_;
+    };
+
+}
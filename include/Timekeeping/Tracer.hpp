@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * @file Tracer.hpp
+ *
+ * This module declares the Timekeeping::Tracer interface.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This represents an object which is told about the lifecycle of
+     * callbacks as they're scheduled, canceled, and called, so that it
+     * can record them as trace events, for example through Perfetto or
+     * LTTng.
+     *
+     * The scheduler only reports these events if the library was built
+     * with the TIMEKEEPING_TRACING option.  Otherwise the calls are
+     * compiled out, and any tracer given to the scheduler is ignored.
+     *
+     * The methods are called by whichever thread does the thing being
+     * reported, usually while the scheduler is busy, so they should be
+     * quick, and mustn't use the scheduler.
+     */
+    class Tracer {
+    public:
+        // Methods
+
+        /**
+         * This method is called when a callback has been scheduled.
+         *
+         * @param[in] token
+         *     This is the token returned for the callback.
+         *
+         * @param[in] due
+         *     This is the time, in ticks of the scheduler's clock, at
+         *     which the callback is due, once any slack is applied.
+         */
+        virtual void Scheduled(
+            uint64_t token,
+            int64_t due
+        ) = 0;
+
+        /**
+         * This method is called when a callback has been canceled.
+         *
+         * @param[in] token
+         *     This is the token returned for the callback.
+         */
+        virtual void Canceled(uint64_t token) = 0;
+
+        /**
+         * This method is called just before a callback which is due
+         * is handed to the scheduler's executor.
+         *
+         * @param[in] token
+         *     This is the token returned for the callback.
+         *
+         * @param[in] due
+         *     This is the time, in ticks of the scheduler's clock, at
+         *     which the callback was due.
+         */
+        virtual void CallbackStarting(
+            uint64_t token,
+            int64_t due
+        ) = 0;
+
+        /**
+         * This method is called once the executor has taken a callback
+         * which is due.  If the executor called the callback directly,
+         * the callback has returned.
+         *
+         * @param[in] token
+         *     This is the token returned for the callback.
+         */
+        virtual void CallbackFinished(uint64_t token) = 0;
+    };
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * @file TscClock.hpp
+ *
+ * This module declares the Timekeeping::TscClock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TickClock.hpp"
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This is a clock which reads the processor's time stamp counter
+     * (TSC), converting cycles to ticks using a rate measured against
+     * std::chrono::steady_clock when the clock is constructed.  It has
+     * the same reference point as SteadyClock.
+     *
+     * Each reading costs roughly 10 nanoseconds, since it needs no
+     * system call or shared memory access, and the resolution is a
+     * single cycle.  The measured rate is only as accurate as the
+     * calibration allows, so the clock drifts from the steady clock by
+     * a few microseconds per second for the default calibration time,
+     * and less for longer ones.  It relies on the "invariant TSC" of
+     * modern x86 processors, which runs at a constant rate on all cores.
+     *
+     * On processors without a TSC, the clock simply reads
+     * std::chrono::steady_clock.
+     */
+    class TscClock
+        : public TickClock
+    {
+        // Public Methods
+    public:
+        /**
+         * This constructs the clock, measuring the rate of the time stamp
+         * counter against the steady clock.
+         *
+         * @param[in] calibrationTime
+         *     This is the length of time, in seconds, over which to measure
+         *     the rate of the time stamp counter.  The constructor blocks
+         *     for this long.
+         */
+        explicit TscClock(double calibrationTime = 0.01);
+
+        /**
+         * Determine whether or not the clock reads the processor's time
+         * stamp counter, rather than the steady clock.
+         *
+         * @return
+         *     An indication of whether or not the clock reads the
+         *     processor's time stamp counter is returned.
+         */
+        bool IsUsingTsc() const;
+
+        // TickClock
+
+        virtual int64_t GetCurrentTicks() override;
+
+        // Private properties
+    private:
+        /**
+         * This is the value of the time stamp counter at the end of
+         * calibration.
+         */
+        uint64_t baseCycles_ = 0;
+
+        /**
+         * This is the value of the steady clock, in ticks, at the end
+         * of calibration.
+         */
+        int64_t baseTicks_ = 0;
+
+        /**
+         * This is the number of ticks per cycle of the time stamp counter,
+         * as a fixed-point number with 32 fractional bits.  It's zero if
+         * the time stamp counter isn't used.
+         */
+        uint64_t ticksPerCycle_ = 0;
+    };
+
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+/**
+ * @file UniqueFunction.hpp
+ *
+ * This module declares the Timekeeping::UniqueFunction class template.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <functional>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace Timekeeping {
+
+    template< typename Signature > class UniqueFunction;
+
+    /**
+     * This is a move-only, type-erased wrapper of a callable object,
+     * similar to std::function, except that it can hold callables which
+     * can't be copied (such as lambdas which capture a std::unique_ptr),
+     * and it keeps small callables in storage inside the wrapper itself,
+     * so that wrapping them doesn't allocate any memory.
+     *
+     * @tparam R
+     *     This is the type of value returned by the callable.
+     *
+     * @tparam Args
+     *     These are the types of the arguments passed to the callable.
+     */
+    template< typename R, typename... Args > class UniqueFunction< R(Args...) > {
+        // Types
+    public:
+        /**
+         * This is the number of bytes of storage inside the wrapper
+         * available for holding the callable.  Callables which are
+         * larger than this are held in memory allocated from the heap.
+         * It's big enough for a lambda capturing a few pointers, or
+         * a couple of std::shared_ptr values.
+         */
+        static constexpr size_t INLINE_SIZE = 4 * sizeof(void*);
+
+        // Lifecycle Methods
+    public:
+        ~UniqueFunction() noexcept {
+            Reset();
+        }
+        UniqueFunction(const UniqueFunction&) = delete;
+        UniqueFunction(UniqueFunction&& other) noexcept {
+            MoveFrom(other);
+        }
+        UniqueFunction& operator=(const UniqueFunction&) = delete;
+        UniqueFunction& operator=(UniqueFunction&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                MoveFrom(other);
+            }
+            return *this;
+        }
+
+        // Public Methods
+    public:
+        /**
+         * This constructs an empty wrapper.
+         */
+        UniqueFunction() noexcept = default;
+
+        /**
+         * This constructs an empty wrapper.
+         */
+        UniqueFunction(std::nullptr_t) noexcept {
+        }
+
+        /**
+         * This constructs a wrapper holding the given callable.
+         *
+         * @param[in] callable
+         *     This is the callable to hold in the wrapper.
+         */
+        template<
+            typename F,
+            typename = typename std::enable_if<
+                !std::is_same<
+                    typename std::decay< F >::type,
+                    UniqueFunction
+                >::value
+            >::type
+        > UniqueFunction(F&& callable) {
+            using Callable = typename std::decay< F >::type;
+            Emplace< Callable >(
+                std::forward< F >(callable),
+                std::integral_constant< bool, StoresInline< Callable >() >()
+            );
+        }
+
+        /**
+         * This makes the wrapper empty, destroying any callable it held.
+         *
+         * @return
+         *     A reference to the wrapper is returned.
+         */
+        UniqueFunction& operator=(std::nullptr_t) noexcept {
+            Reset();
+            return *this;
+        }
+
+        /**
+         * Determine whether or not the wrapper holds a callable.
+         *
+         * @return
+         *     An indication of whether or not the wrapper holds a callable
+         *     is returned.
+         */
+        explicit operator bool() const noexcept {
+            return (operations_ != nullptr);
+        }
+
+        /**
+         * Call the callable held by the wrapper.
+         *
+         * @param[in] args
+         *     These are the arguments to pass to the callable.
+         *
+         * @return
+         *     The value returned by the callable is returned.
+         *
+         * @throw std::bad_function_call
+         *     This is thrown if the wrapper is empty.
+         */
+        R operator()(Args... args) {
+            if (operations_ == nullptr) {
+                throw std::bad_function_call();
+            }
+            return operations_->invoke(&storage_, std::forward< Args >(args)...);
+        }
+
+        /**
+         * Determine whether or not a callable of the given type can be
+         * held in the storage inside the wrapper, rather than in memory
+         * allocated from the heap.
+         *
+         * @tparam Callable
+         *     This is the type of callable to check.
+         *
+         * @return
+         *     An indication of whether or not a callable of the given type
+         *     can be held inside the wrapper is returned.
+         */
+        template< typename Callable > static constexpr bool StoresInline() {
+            return (
+                (sizeof(Callable) <= INLINE_SIZE)
+                && (alignof(Callable) <= alignof(Storage))
+                && std::is_nothrow_move_constructible< Callable >::value
+            );
+        }
+
+        // Private Types
+    private:
+        /**
+         * This is the type of storage used to hold the callable, or a
+         * pointer to it, if it's too big to fit.
+         */
+        using Storage = typename std::aligned_storage<
+            INLINE_SIZE,
+            alignof(void*)
+        >::type;
+
+        /**
+         * This holds the functions used to operate on the callable,
+         * whose type is only known when the wrapper is constructed.
+         */
+        struct Operations {
+            /**
+             * This calls the callable.
+             */
+            R (*invoke)(Storage* storage, Args&&... args);
+
+            /**
+             * This moves the callable from one wrapper's storage to
+             * another's, leaving nothing to destroy in the former.
+             */
+            void (*move)(Storage* from, Storage* to);
+
+            /**
+             * This destroys the callable.
+             */
+            void (*destroy)(Storage* storage);
+        };
+
+        // Private Methods
+    private:
+        /**
+         * Hold the given callable in the storage inside the wrapper.
+         *
+         * @tparam Callable
+         *     This is the type of the callable.
+         *
+         * @param[in] callable
+         *     This is the callable to hold in the wrapper.
+         */
+        template< typename Callable, typename F > void Emplace(
+            F&& callable,
+            std::true_type
+        ) {
+            ::new ((void*)&storage_) Callable(std::forward< F >(callable));
+            operations_ = GetInlineOperations< Callable >();
+        }
+
+        /**
+         * Hold the given callable in memory allocated from the heap.
+         *
+         * @tparam Callable
+         *     This is the type of the callable.
+         *
+         * @param[in] callable
+         *     This is the callable to hold in the wrapper.
+         */
+        template< typename Callable, typename F > void Emplace(
+            F&& callable,
+            std::false_type
+        ) {
+            *reinterpret_cast< Callable** >(&storage_) = new Callable(
+                std::forward< F >(callable)
+            );
+            operations_ = GetHeapOperations< Callable >();
+        }
+
+        /**
+         * Return the functions used to operate on a callable of the given
+         * type held in the storage inside the wrapper.
+         *
+         * @tparam Callable
+         *     This is the type of the callable.
+         *
+         * @return
+         *     The functions used to operate on the callable are returned.
+         */
+        template< typename Callable > static const Operations* GetInlineOperations() {
+            static const Operations operations = {
+                [](Storage* storage, Args&&... args) -> R {
+                    return (*reinterpret_cast< Callable* >(storage))(
+                        std::forward< Args >(args)...
+                    );
+                },
+                [](Storage* from, Storage* to) {
+                    auto callable = reinterpret_cast< Callable* >(from);
+                    ::new ((void*)to) Callable(std::move(*callable));
+                    callable->~Callable();
+                },
+                [](Storage* storage) {
+                    reinterpret_cast< Callable* >(storage)->~Callable();
+                },
+            };
+            return &operations;
+        }
+
+        /**
+         * Return the functions used to operate on a callable of the given
+         * type held in memory allocated from the heap.
+         *
+         * @tparam Callable
+         *     This is the type of the callable.
+         *
+         * @return
+         *     The functions used to operate on the callable are returned.
+         */
+        template< typename Callable > static const Operations* GetHeapOperations() {
+            static const Operations operations = {
+                [](Storage* storage, Args&&... args) -> R {
+                    return (**reinterpret_cast< Callable** >(storage))(
+                        std::forward< Args >(args)...
+                    );
+                },
+                [](Storage* from, Storage* to) {
+                    *reinterpret_cast< Callable** >(to) = (
+                        *reinterpret_cast< Callable** >(from)
+                    );
+                },
+                [](Storage* storage) {
+                    delete *reinterpret_cast< Callable** >(storage);
+                },
+            };
+            return &operations;
+        }
+
+        /**
+         * Take the callable held by the given wrapper, leaving it empty.
+         * This wrapper must be empty.
+         *
+         * @param[in,out] other
+         *     This is the wrapper from which to take the callable.
+         */
+        void MoveFrom(UniqueFunction& other) noexcept {
+            if (other.operations_ != nullptr) {
+                other.operations_->move(&other.storage_, &storage_);
+                operations_ = other.operations_;
+                other.operations_ = nullptr;
+            }
+        }
+
+        /**
+         * Destroy the callable held by the wrapper, if any, leaving it empty.
+         */
+        void Reset() noexcept {
+            if (operations_ != nullptr) {
+                const auto operations = operations_;
+                operations_ = nullptr;
+                operations->destroy(&storage_);
+            }
+        }
+
+        // Private Properties
+    private:
+        /**
+         * This holds the callable, or a pointer to it, if it's too big
+         * to fit.
+         */
+        Storage storage_;
+
+        /**
+         * This points to the functions used to operate on the callable,
+         * or is null if the wrapper is empty.
+         */
+        const Operations* operations_ = nullptr;
+    };
+
+    template< typename R, typename... Args >
+    constexpr size_t UniqueFunction< R(Args...) >::INLINE_SIZE;
+
+}
@@ -0,0 +1,42 @@
+/**
+ * @file Clock.cpp
+ *
+ * This module contains the implementation of the Timekeeping::Clock
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <math.h>
+#include <Timekeeping/Clock.hpp>
+
+namespace Timekeeping {
+
+    constexpr int64_t Clock::TICKS_PER_SECOND;
+
+    int64_t Clock::GetCurrentTicks() {
+        return SecondsToTicks(GetCurrentTime());
+    }
+
+    int64_t Clock::SecondsToTicks(double seconds) {
+        // The limits are compared as doubles, which can't represent
+        // INT64_MAX exactly, so anything at or beyond the nearest double
+        // saturates rather than overflowing.
+        const auto ticks = round(seconds * (double)TICKS_PER_SECOND);
+        if (ticks != ticks) {
+            return INT64_MAX;
+        }
+        if (ticks >= (double)INT64_MAX) {
+            return INT64_MAX;
+        }
+        if (ticks <= (double)INT64_MIN) {
+            return INT64_MIN;
+        }
+        return (int64_t)ticks;
+    }
+
+    double Clock::TicksToSeconds(int64_t ticks) {
+        return (double)ticks / (double)TICKS_PER_SECOND;
+    }
+
+}
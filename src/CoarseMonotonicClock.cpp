@@ -0,0 +1,31 @@
+/**
+ * @file CoarseMonotonicClock.cpp
+ *
+ * This module contains the implementation of the
+ * Timekeeping::CoarseMonotonicClock class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <Timekeeping/CoarseMonotonicClock.hpp>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+namespace Timekeeping {
+
+    int64_t CoarseMonotonicClock::GetCurrentTicks() {
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+        struct timespec now;
+        (void)clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return (int64_t)now.tv_sec * TICKS_PER_SECOND + (int64_t)now.tv_nsec;
+#else
+        return (int64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+#endif
+    }
+
+}
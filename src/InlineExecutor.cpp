@@ -0,0 +1,22 @@
+/**
+ * @file InlineExecutor.cpp
+ *
+ * This module contains the implementation of the
+ * Timekeeping::InlineExecutor class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Timekeeping/InlineExecutor.hpp>
+
+namespace Timekeeping {
+
+    void InlineExecutor::Execute(
+        Task task,
+        uint64_t strand
+    ) {
+        (void)strand;
+        task();
+    }
+
+}
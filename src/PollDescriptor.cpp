@@ -0,0 +1,114 @@
+/**
+ * @file PollDescriptor.cpp
+ *
+ * This module contains the implementation of the
+ * Timekeeping::PollDescriptor class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "PollDescriptor.hpp"
+
+#include <initializer_list>
+#include <Timekeeping/Clock.hpp>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace Timekeeping {
+
+    PollDescriptor::~PollDescriptor() noexcept {
+#if defined(__linux__)
+        for (const auto descriptor: {epoll_, timer_, event_}) {
+            if (descriptor >= 0) {
+                (void)close(descriptor);
+            }
+        }
+#endif
+    }
+
+    PollDescriptor::PollDescriptor() {
+#if defined(__linux__)
+        timer_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        if (
+            (timer_ < 0)
+            || (event_ < 0)
+            || (epoll_ < 0)
+        ) {
+            return;
+        }
+        for (const auto descriptor: {timer_, event_}) {
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = descriptor;
+            if (epoll_ctl(epoll_, EPOLL_CTL_ADD, descriptor, &event) != 0) {
+                (void)close(epoll_);
+                epoll_ = -1;
+                return;
+            }
+        }
+#endif
+    }
+
+    int PollDescriptor::Get() const {
+#if defined(__linux__)
+        if (
+            (timer_ < 0)
+            || (event_ < 0)
+        ) {
+            return -1;
+        }
+#endif
+        return epoll_;
+    }
+
+    void PollDescriptor::Arm(int64_t delay) {
+#if defined(__linux__)
+        if (timer_ < 0) {
+            return;
+        }
+        // Rearming the timer also resets its count of expirations, so
+        // the descriptor stops being readable on account of the timer.
+        // An all-zero setting disarms the timer, so the shortest delay
+        // is one nanosecond.
+        struct itimerspec setting = {};
+        if (delay != INT64_MAX) {
+            if (delay < 1) {
+                delay = 1;
+            }
+            setting.it_value.tv_sec = (time_t)(delay / Clock::TICKS_PER_SECOND);
+            setting.it_value.tv_nsec = (long)(delay % Clock::TICKS_PER_SECOND);
+        }
+        (void)timerfd_settime(timer_, 0, &setting, nullptr);
+#else
+        (void)delay;
+#endif
+    }
+
+    void PollDescriptor::Signal() {
+#if defined(__linux__)
+        if (event_ < 0) {
+            return;
+        }
+        const uint64_t one = 1;
+        (void)!write(event_, &one, sizeof(one));
+#endif
+    }
+
+    void PollDescriptor::Clear() {
+#if defined(__linux__)
+        if (event_ < 0) {
+            return;
+        }
+        uint64_t count;
+        (void)!read(event_, &count, sizeof(count));
+#endif
+    }
+
+}
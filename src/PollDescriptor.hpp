@@ -0,0 +1,91 @@
+#pragma once
+
+/**
+ * @file PollDescriptor.hpp
+ *
+ * This module declares the Timekeeping::PollDescriptor class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <stdint.h>
+
+namespace Timekeeping {
+
+    /**
+     * This is a file descriptor which can be polled, along with other file
+     * descriptors, to find out when a threadless scheduler needs attention,
+     * either because its next deadline has been reached, or because a
+     * callback was scheduled which may be due sooner.
+     *
+     * On Linux, this is an epoll descriptor holding a timerfd, which is
+     * armed for the next deadline, and an eventfd, which is written to
+     * when the deadline changes.  It isn't available on other platforms.
+     */
+    class PollDescriptor {
+        // Lifecycle Methods
+    public:
+        ~PollDescriptor() noexcept;
+        PollDescriptor(const PollDescriptor&) = delete;
+        PollDescriptor(PollDescriptor&&) = delete;
+        PollDescriptor& operator=(const PollDescriptor&) = delete;
+        PollDescriptor& operator=(PollDescriptor&&) = delete;
+
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         */
+        PollDescriptor();
+
+        /**
+         * Return the file descriptor to poll.
+         *
+         * @return
+         *     The file descriptor to poll is returned, or -1 if it
+         *     couldn't be made, or isn't available on this platform.
+         */
+        int Get() const;
+
+        /**
+         * Arrange for the descriptor to become readable once the given
+         * length of time has passed, replacing any earlier arrangement.
+         *
+         * @param[in] delay
+         *     This is the number of nanoseconds from now at which the
+         *     descriptor should become readable.  If it's zero or less,
+         *     the descriptor becomes readable right away.  If it's
+         *     INT64_MAX, the descriptor doesn't become readable due to
+         *     the passing of time at all.
+         */
+        void Arm(int64_t delay);
+
+        /**
+         * Make the descriptor readable right away, from any thread.
+         */
+        void Signal();
+
+        /**
+         * Undo the effect of any earlier calls to Signal.
+         */
+        void Clear();
+
+        // Private properties
+    private:
+        /**
+         * This is the epoll descriptor which holds the other two.
+         */
+        int epoll_ = -1;
+
+        /**
+         * This is the timerfd which is armed for the next deadline.
+         */
+        int timer_ = -1;
+
+        /**
+         * This is the eventfd which is written to by Signal.
+         */
+        int event_ = -1;
+    };
+
+}
@@ -6,29 +6,923 @@
  * © 2018 by Richard Walters
  */
 
+#include "PollDescriptor.hpp"
+#include "SlotTable.hpp"
+#include "TimerHeap.hpp"
+#include "TimerQueue.hpp"
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <condition_variable>
-#include <map>
-#include <math.h>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <Timekeeping/InlineExecutor.hpp>
 #include <Timekeeping/Scheduler.hpp>
+#include <Timekeeping/SteadyClock.hpp>
+#include <Timekeeping/ThreadPool.hpp>
+#include <Timekeeping/Tracer.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace {
 
-    struct ScheduledCallback {
+    /**
+     * This indicates whether or not the library was built to report
+     * the lifecycle of callbacks to the tracer given to the scheduler.
+     * When it isn't, the calls to the tracer are compiled out.
+     */
+#if defined(TIMEKEEPING_TRACING)
+    constexpr bool TRACING = true;
+#else
+    constexpr bool TRACING = false;
+#endif
+
+    /**
+     * This holds a callback which has been taken from the queue because
+     * it's due, and is about to be called.
+     */
+    struct DueCallback {
         // Properties
 
-        int token;
-        double due;
         Timekeeping::Scheduler::Callback callback;
+        int64_t due;
+        uint64_t strand;
+        Timekeeping::Scheduler::Token token;
+        const char* site;
+    };
+
+    /**
+     * This is the number of bits of a token which hold the index
+     * of the slot of the scheduled callback.
+     */
+    constexpr unsigned int TOKEN_SLOT_BITS = 32;
+
+    /**
+     * This is the number of bits of a token, above the slot index bits,
+     * which hold the index of the shard holding the scheduled callback.
+     * The remaining upper bits hold the generation of the slot.
+     */
+    constexpr unsigned int TOKEN_SHARD_BITS = 8;
+
+    /**
+     * This is the number of bits of a token which hold the generation
+     * of the slot of the scheduled callback.
+     */
+    constexpr unsigned int TOKEN_GENERATION_BITS = (
+        64 - TOKEN_SLOT_BITS - TOKEN_SHARD_BITS
+    );
+
+    /**
+     * This is used to select the slot index bits of a token.
+     */
+    constexpr uint64_t TOKEN_SLOT_MASK = ((uint64_t)1 << TOKEN_SLOT_BITS) - 1;
+
+    /**
+     * This is used to select the shard index bits of a token, once shifted
+     * down past the slot index bits.
+     */
+    constexpr uint64_t TOKEN_SHARD_MASK = ((uint64_t)1 << TOKEN_SHARD_BITS) - 1;
+
+    /**
+     * This is used to keep slot generations within the bits of a token
+     * available to hold them.
+     */
+    constexpr uint32_t GENERATION_MASK = (
+        ((uint32_t)1 << TOKEN_GENERATION_BITS) - 1
+    );
+
+    /**
+     * This is the largest number of shards a scheduler may have.
+     */
+    constexpr size_t MAX_SHARDS = (size_t)1 << TOKEN_SHARD_BITS;
+
+    /**
+     * This is the longest the worker thread waits at once, in clock
+     * ticks.  It keeps the steady clock deadline well within range even
+     * when the next callback is due very far away.
+     */
+    constexpr int64_t MAX_WAIT = (int64_t)3600 * Timekeeping::Clock::TICKS_PER_SECOND;
+
+    /**
+     * This is the shortest the worker thread waits at once in precise
+     * waiting mode, in clock ticks.  It keeps the worker from spinning
+     * hard if the clock isn't moving.
+     */
+    constexpr int64_t MIN_PRECISE_WAIT = 1000;
+
+    /**
+     * This is the fewest tokens a scheduler made by a timer service keeps
+     * before it prunes those of callbacks which are no longer scheduled.
+     */
+    constexpr size_t MIN_TRACKED_TOKENS_TO_PRUNE = 64;
+
+    /**
+     * This is the number of clock ticks in one millisecond.
+     */
+    constexpr int64_t TICKS_PER_MILLISECOND = Timekeeping::Clock::TICKS_PER_SECOND / 1000;
+
+    /**
+     * Add the given nonnegative number of ticks to the given time,
+     * saturating rather than overflowing.
+     *
+     * @param[in] time
+     *     This is the time to which to add.
+     *
+     * @param[in] ticks
+     *     This is the number of ticks to add.  It must not be negative.
+     *
+     * @return
+     *     The sum is returned.
+     */
+    int64_t AddTicks(int64_t time, int64_t ticks) {
+        if (time > INT64_MAX - ticks) {
+            return INT64_MAX;
+        }
+        return time + ticks;
+    }
+
+    /**
+     * Return the time at which a callback due at the given time, with
+     * the given slack, should actually be called.  The due time is moved
+     * later, to the next multiple of the largest power of two which isn't
+     * more than the slack, so that callbacks due around the same time,
+     * with similar slack, are all called at the same time.
+     *
+     * @param[in] due
+     *     This is the time at which the callback is due.
+     *
+     * @param[in] slack
+     *     This is how much later than the due time the callback may be
+     *     called.
+     *
+     * @return
+     *     The time at which to call the callback is returned.
+     */
+    int64_t ApplySlack(int64_t due, int64_t slack) {
+        if (slack <= 0) {
+            return due;
+        }
+        int64_t granularity = 1;
+        while (granularity <= slack / 2) {
+            granularity <<= 1;
+        }
+        const auto remainder = ((due % granularity) + granularity) % granularity;
+        if (remainder == 0) {
+            return due;
+        }
+        return AddTicks(due, granularity - remainder);
+    }
+
+    /**
+     * Convert the given length of time in seconds to nanoseconds.
+     *
+     * @param[in] seconds
+     *     This is the length of time to convert.
+     *
+     * @return
+     *     The length of time in nanoseconds is returned.
+     */
+    std::chrono::nanoseconds ToNanoseconds(double seconds) {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::duration< double >(seconds)
+        );
+    }
+
+    /**
+     * Return the current time of the system's steady clock, in
+     * nanoseconds.
+     *
+     * @return
+     *     The current time of the system's steady clock is returned.
+     */
+    int64_t GetSteadyNanoseconds() {
+        return (int64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    /**
+     * Tell the processor that the current thread is spinning, so that
+     * it can save power or give resources to other hardware threads.
+     */
+    void CpuRelax() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /**
+     * This counts how many values fall into each of a number of ranges,
+     * each twice as wide as the one before, and keeps track of the largest
+     * value, so that percentiles of the values can be estimated cheaply.
+     * Values may be recorded by more than one thread at a time.
+     */
+    struct Histogram {
+        // Properties
+
+        /**
+         * This is the number of ranges of values counted.  The first
+         * counts values of zero, and each other counts values with one
+         * more significant bit than the range before it.
+         */
+        static constexpr size_t BUCKETS = 65;
+
+        std::atomic< uint64_t > buckets[BUCKETS];
+        std::atomic< uint64_t > maximum{0};
+
+        // Methods
+
+        Histogram() {
+            for (auto& bucket: buckets) {
+                bucket = 0;
+            }
+        }
+
+        void Record(uint64_t value) {
+            size_t bucket;
+#if defined(__GNUC__) || defined(__clang__)
+            bucket = (
+                (value == 0)
+                ? 0
+                : (size_t)(64 - __builtin_clzll(value))
+            );
+#else
+            bucket = 0;
+            while ((value >> bucket) != 0) {
+                ++bucket;
+            }
+#endif
+            (void)buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            auto largest = maximum.load(std::memory_order_relaxed);
+            while (
+                (value > largest)
+                && !maximum.compare_exchange_weak(
+                    largest,
+                    value,
+                    std::memory_order_relaxed
+                )
+            ) {
+            }
+        }
+
+        uint64_t GetPercentile(double fraction) const {
+            uint64_t counts[BUCKETS];
+            uint64_t total = 0;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                counts[i] = buckets[i].load(std::memory_order_relaxed);
+                total += counts[i];
+            }
+            if (total == 0) {
+                return 0;
+            }
+            const auto rank = std::max(
+                (uint64_t)1,
+                (uint64_t)std::ceil(fraction * (double)total)
+            );
+            const auto largest = maximum.load(std::memory_order_relaxed);
+            uint64_t counted = 0;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                counted += counts[i];
+                if (counted >= rank) {
+                    if (i == 0) {
+                        return 0;
+                    }
+                    const auto upperBound = (
+                        (i == 64)
+                        ? UINT64_MAX
+                        : (((uint64_t)1 << i) - 1)
+                    );
+                    return std::min(upperBound, largest);
+                }
+            }
+            return largest;
+        }
+    };
+
+    /**
+     * This is used to give each thread which uses any scheduler its own
+     * number, which is used to pick which shard of a scheduler the thread
+     * puts the callbacks it schedules into.
+     */
+    std::atomic< size_t > nextThreadNumber{0};
+
+    /**
+     * This is the number of the current thread, used to pick which shard
+     * of a scheduler the thread puts the callbacks it schedules into.
+     */
+    thread_local size_t threadNumber = nextThreadNumber++;
+
+    /**
+     * This is used to select the bits of the head of a list of free
+     * slots which hold one more than the index of the first free slot.
+     * The remaining upper bits count changes made to the list, so that a
+     * thread taking a slot from the list can tell if the list changed
+     * while it was looking at it.
+     */
+    constexpr uint64_t FREE_SLOT_MASK = ((uint64_t)1 << 32) - 1;
+
+    /**
+     * Return the status a slot with the given status should have once
+     * it's freed.
+     *
+     * @param[in] status
+     *     This is the status of the slot to free.
+     *
+     * @return
+     *     The status of the slot once freed is returned.
+     */
+    uint32_t FreedStatus(uint32_t status) {
+        auto generation = (
+            ((status >> Timekeeping::SLOT_GENERATION_SHIFT) + 1) & GENERATION_MASK
+        );
+        if (generation == 0) {
+            generation = 1;
+        }
+        return generation << Timekeeping::SLOT_GENERATION_SHIFT;
+    }
+
+    /**
+     * Return the status which the slot of the scheduled callback
+     * corresponding to the given token has while the callback is still
+     * scheduled.
+     *
+     * @param[in] token
+     *     This represents the scheduled callback.
+     *
+     * @return
+     *     The status of the slot of the scheduled callback is returned.
+     */
+    uint32_t ScheduledStatus(Timekeeping::Scheduler::Token token) {
+        return (
+            ((uint32_t)(token >> (TOKEN_SLOT_BITS + TOKEN_SHARD_BITS)) << Timekeeping::SLOT_GENERATION_SHIFT)
+            | Timekeeping::SLOT_ALLOCATED
+        );
+    }
+
+    /**
+     * This marks the start of a snapshot of scheduled callbacks.
+     */
+    constexpr uint32_t SNAPSHOT_MAGIC = 0x4E534B54;
+
+    /**
+     * This is the version of the format of snapshots made now.
+     */
+    constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+    /**
+     * This is the number of bytes at the start of a snapshot, holding the
+     * magic number, version, and number of records.
+     */
+    constexpr size_t SNAPSHOT_HEADER_SIZE = 16;
+
+    /**
+     * This is the number of bytes of each record of a snapshot.
+     */
+    constexpr size_t SNAPSHOT_RECORD_SIZE = 48;
+
+    /**
+     * Append the given number of low bytes of the given value to the given
+     * buffer, least significant first, so that snapshots are the same on
+     * every machine.
+     *
+     * @param[in,out] buffer
+     *     This is the buffer to which to append the bytes.
+     *
+     * @param[in] value
+     *     This is the value to append.
+     *
+     * @param[in] bytes
+     *     This is the number of bytes to append.
+     */
+    void PutBytes(std::vector< uint8_t >& buffer, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            buffer.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    /**
+     * Return the value stored in the given number of bytes at the given
+     * place, least significant first.
+     *
+     * @param[in] buffer
+     *     This points to the bytes holding the value.
+     *
+     * @param[in] bytes
+     *     This is the number of bytes holding the value.
+     *
+     * @return
+     *     The value is returned.
+     */
+    uint64_t GetBytes(const uint8_t* buffer, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= (uint64_t)buffer[i] << (8 * i);
+        }
+        return value;
+    }
+
+    /**
+     * Append a record of the given scheduled callback to the given
+     * snapshot.
+     *
+     * @param[in,out] snapshot
+     *     This is the snapshot to which to append the record.
+     *
+     * @param[in] scheduledCallback
+     *     This is the scheduled callback to record.
+     */
+    void AppendSnapshotRecord(
+        std::vector< uint8_t >& snapshot,
+        const Timekeeping::ScheduledCallback& scheduledCallback
+    ) {
+        PutBytes(snapshot, scheduledCallback.type, 4);
+        PutBytes(snapshot, (uint64_t)scheduledCallback.periodicMode, 1);
+        PutBytes(snapshot, (uint64_t)scheduledCallback.catchUp, 1);
+        PutBytes(snapshot, 0, 2);
+        PutBytes(snapshot, scheduledCallback.key, 8);
+        PutBytes(snapshot, (uint64_t)scheduledCallback.requestedDue, 8);
+        PutBytes(snapshot, (uint64_t)scheduledCallback.slack, 8);
+        PutBytes(snapshot, (uint64_t)scheduledCallback.interval, 8);
+        PutBytes(snapshot, scheduledCallback.strand, 8);
+    }
+
+    /**
+     * This holds one independently locked portion of the scheduled
+     * callbacks of a scheduler.
+     *
+     * Slots are taken from and returned to the list of free slots without
+     * holding the lock, so that in lock-free submission mode, callbacks
+     * can be scheduled without it.  In that mode, slots holding callbacks
+     * which have been scheduled or canceled are pushed onto lists which
+     * the worker thread takes in one go.  Slots are only freed, and the
+     * timer queue is only used, while holding the lock.  Threads using
+     * the shard without the lock count themselves in unlockedUsers, so
+     * that the shard isn't cleared under them.
+     */
+    struct Shard {
+        // Properties
+
+        size_t index = 0;
+        std::recursive_mutex mutex;
+        Timekeeping::SlotTable slots;
+        std::atomic< uint64_t > freeSlots{0};
+        std::atomic< size_t > submissions{Timekeeping::NO_SLOT};
+        std::atomic< size_t > cancellations{Timekeeping::NO_SLOT};
+        std::unique_ptr< Timekeeping::TimerQueue > scheduledCallbacks;
+        std::atomic< uint64_t > pending{0};
+        std::atomic< uint64_t > canceledUnreclaimed{0};
+        std::atomic< size_t > unlockedUsers{0};
 
         // Methods
 
-        bool operator>(const ScheduledCallback& other) const {
-            return due > other.due;
+        Timekeeping::Scheduler::Token MakeToken(size_t slot) {
+            const auto generation = (
+                slots[slot].status.load(std::memory_order_relaxed)
+                >> Timekeeping::SLOT_GENERATION_SHIFT
+            );
+            return (
+                ((Timekeeping::Scheduler::Token)generation << (TOKEN_SLOT_BITS + TOKEN_SHARD_BITS))
+                | ((Timekeeping::Scheduler::Token)index << TOKEN_SLOT_BITS)
+                | (Timekeeping::Scheduler::Token)slot
+            );
+        }
+
+        bool MarkCanceled(Timekeeping::Scheduler::Token token, size_t& slot) {
+            slot = (size_t)(token & TOKEN_SLOT_MASK);
+            const auto scheduledCallback = slots.Find(slot);
+            if (scheduledCallback == nullptr) {
+                return false;
+            }
+            auto status = ScheduledStatus(token);
+            if (
+                !scheduledCallback->status.compare_exchange_strong(
+                    status,
+                    status | Timekeeping::SLOT_CANCELED,
+                    std::memory_order_acq_rel
+                )
+            ) {
+                return false;
+            }
+            (void)pending.fetch_sub(1, std::memory_order_relaxed);
+            (void)canceledUnreclaimed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool MarkSlotCanceled(size_t slot) {
+            auto& status = slots[slot].status;
+            auto expected = status.load(std::memory_order_relaxed);
+            while ((expected & Timekeeping::SLOT_CANCELED) == 0) {
+                if (
+                    status.compare_exchange_weak(
+                        expected,
+                        expected | Timekeeping::SLOT_CANCELED,
+                        std::memory_order_acq_rel
+                    )
+                ) {
+                    (void)pending.fetch_sub(1, std::memory_order_relaxed);
+                    (void)canceledUnreclaimed.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool FindScheduled(Timekeeping::Scheduler::Token token, size_t& slot) {
+            slot = (size_t)(token & TOKEN_SLOT_MASK);
+            const auto scheduledCallback = slots.Find(slot);
+            return (
+                (scheduledCallback != nullptr)
+                && (
+                    scheduledCallback->status.load(std::memory_order_acquire)
+                    == ScheduledStatus(token)
+                )
+            );
+        }
+
+        bool MarkCalled(size_t slot) {
+            auto& status = slots[slot].status;
+            auto expected = status.load(std::memory_order_relaxed);
+            while ((expected & Timekeeping::SLOT_CANCELED) == 0) {
+                if (
+                    status.compare_exchange_weak(
+                        expected,
+                        FreedStatus(expected),
+                        std::memory_order_acq_rel
+                    )
+                ) {
+                    (void)pending.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        size_t AllocateSlot() {
+            auto head = freeSlots.load(std::memory_order_acquire);
+            while ((head & FREE_SLOT_MASK) != 0) {
+                const auto slot = (size_t)(head & FREE_SLOT_MASK) - 1;
+                const auto newHead = (
+                    (((head >> 32) + 1) << 32)
+                    | slots[slot].nextFree.load(std::memory_order_relaxed)
+                );
+                if (
+                    freeSlots.compare_exchange_weak(
+                        head,
+                        newHead,
+                        std::memory_order_acquire
+                    )
+                ) {
+                    return slot;
+                }
+            }
+            return slots.Add();
+        }
+
+        size_t PrepareSlot(Timekeeping::Scheduler::ScheduleRequest&& request) {
+            const auto slot = AllocateSlot();
+            if (slot == Timekeeping::NO_SLOT) {
+                return slot;
+            }
+            auto& scheduledCallback = slots[slot];
+            scheduledCallback.requestedDue = request.due.count();
+            scheduledCallback.slack = std::max((int64_t)0, (int64_t)request.slack.count());
+            scheduledCallback.due = ApplySlack(
+                scheduledCallback.requestedDue,
+                scheduledCallback.slack
+            );
+            scheduledCallback.callback = std::move(request.callback);
+            scheduledCallback.strand = request.strand;
+            scheduledCallback.interval = std::max((int64_t)0, (int64_t)request.interval.count());
+            scheduledCallback.periodicMode = request.periodicMode;
+            scheduledCallback.catchUp = request.catchUp;
+            scheduledCallback.site = request.site;
+            scheduledCallback.type = request.type;
+            scheduledCallback.key = request.key;
+            // The slot is marked as allocated only once it's filled in,
+            // so that a snapshot taken at the same time either skips the
+            // slot or sees all of it.
+            scheduledCallback.status.store(
+                scheduledCallback.status.load(std::memory_order_relaxed)
+                | Timekeeping::SLOT_ALLOCATED,
+                std::memory_order_release
+            );
+            (void)pending.fetch_add(1, std::memory_order_relaxed);
+            return slot;
+        }
+
+        Timekeeping::Scheduler::Callback FreeSlot(size_t slot) {
+            auto& scheduledCallback = slots[slot];
+            auto callback = std::move(scheduledCallback.callback);
+            scheduledCallback.callback = nullptr;
+            scheduledCallback.rescheduledDue = Timekeeping::NO_DUE;
+            scheduledCallback.submitted = false;
+            scheduledCallback.cancellationReceived = false;
+            PushFreeSlot(slot);
+            return callback;
+        }
+
+        void PushFreeSlot(size_t slot) {
+            auto& scheduledCallback = slots[slot];
+            auto head = freeSlots.load(std::memory_order_relaxed);
+            for (;;) {
+                scheduledCallback.nextFree.store(
+                    (uint32_t)(head & FREE_SLOT_MASK),
+                    std::memory_order_relaxed
+                );
+                const auto newHead = (
+                    (((head >> 32) + 1) << 32)
+                    | (uint64_t)(slot + 1)
+                );
+                if (
+                    freeSlots.compare_exchange_weak(
+                        head,
+                        newHead,
+                        std::memory_order_release,
+                        std::memory_order_relaxed
+                    )
+                ) {
+                    break;
+                }
+            }
+        }
+
+        void Reserve(size_t count) {
+            // The new slots are freed in reverse order, so that the ones
+            // with the lowest indexes are used first.
+            std::vector< size_t > added;
+            while (slots.GetSize() < count) {
+                const auto slot = slots.Add();
+                if (slot == Timekeeping::NO_SLOT) {
+                    break;
+                }
+                added.push_back(slot);
+            }
+            for (auto slot = added.rbegin(); slot != added.rend(); ++slot) {
+                PushFreeSlot(*slot);
+            }
+            scheduledCallbacks->Reserve(count);
+        }
+
+        void ShrinkToFit() {
+            // This must only be called while holding the lock, and not
+            // in lock-free submission mode, so that nothing else can be
+            // using the list of free slots.  Every chunk of slots past
+            // the last slot in use is released, and the list of free
+            // slots is rebuilt from the slots which are left.
+            const auto size = slots.GetSize();
+            std::vector< bool > isFree(size, false);
+            auto head = freeSlots.load(std::memory_order_relaxed);
+            for (
+                auto next = (size_t)(head & FREE_SLOT_MASK);
+                next != 0;
+                next = slots[next - 1].nextFree.load(std::memory_order_relaxed)
+            ) {
+                isFree[next - 1] = true;
+            }
+            auto used = size;
+            while (
+                (used > 0)
+                && isFree[used - 1]
+            ) {
+                --used;
+            }
+            const auto kept = Timekeeping::SlotTable::GetChunkStart(used);
+            if (kept < size) {
+                uint32_t lastGeneration = 0;
+                for (auto slot = kept; slot < size; ++slot) {
+                    lastGeneration = std::max(
+                        lastGeneration,
+                        slots[slot].status.load(std::memory_order_relaxed)
+                        >> Timekeeping::SLOT_GENERATION_SHIFT
+                    );
+                }
+                slots.Truncate(
+                    kept,
+                    FreedStatus(lastGeneration << Timekeeping::SLOT_GENERATION_SHIFT)
+                );
+                freeSlots.store(
+                    ((head >> 32) + 1) << 32,
+                    std::memory_order_relaxed
+                );
+                for (auto slot = kept; slot > 0; --slot) {
+                    if (isFree[slot - 1]) {
+                        PushFreeSlot(slot - 1);
+                    }
+                }
+            }
+            scheduledCallbacks->ShrinkToFit();
+        }
+
+        void Clear(std::vector< Timekeeping::Scheduler::Callback >& released) {
+            // This must only be called while holding the lock, once
+            // nothing else can be using the shard, even without the lock.
+            // The callbacks are handed back rather than destroyed here,
+            // so that they're destroyed only once the lock is released.
+            // No more callbacks are scheduled once the scheduler is shut
+            // down, so the slots added afterwards, if any, don't need to
+            // be given later generations than the ones released.
+            const auto size = slots.GetSize();
+            for (size_t slot = 0; slot < size; ++slot) {
+                auto& callback = slots[slot].callback;
+                if (callback) {
+                    released.push_back(std::move(callback));
+                }
+            }
+            scheduledCallbacks->Clear();
+            submissions.store(Timekeeping::NO_SLOT);
+            cancellations.store(Timekeeping::NO_SLOT);
+            freeSlots.store(
+                ((freeSlots.load(std::memory_order_relaxed) >> 32) + 1) << 32,
+                std::memory_order_relaxed
+            );
+            pending.store(0, std::memory_order_relaxed);
+            canceledUnreclaimed.store(0, std::memory_order_relaxed);
+            slots.Truncate(0, 1 << Timekeeping::SLOT_GENERATION_SHIFT);
+        }
+
+        Timekeeping::Scheduler::Callback FreeCanceledSlot(size_t slot) {
+            auto& status = slots[slot].status;
+            status.store(
+                FreedStatus(status.load(std::memory_order_relaxed)),
+                std::memory_order_relaxed
+            );
+            (void)canceledUnreclaimed.fetch_sub(1, std::memory_order_relaxed);
+            return FreeSlot(slot);
+        }
+
+        void ReleaseCanceledSlot(
+            size_t slot,
+            std::vector< Timekeeping::Scheduler::Callback >& released
+        ) {
+            auto callback = FreeCanceledSlot(slot);
+            if (callback) {
+                released.push_back(std::move(callback));
+            }
+        }
+
+        Timekeeping::Scheduler::Callback TakeCanceledCallback(size_t slot) {
+            // In lock-free submission mode, this is called without the
+            // lock by the thread which canceled the callback, before it
+            // hands the slot to the worker thread.  Until then, nothing
+            // else touches the callback, unless it's periodic, in which
+            // case it may be being called in place, so it's left for the
+            // worker thread to free along with the slot.
+            auto& scheduledCallback = slots[slot];
+            if (scheduledCallback.interval != 0) {
+                return nullptr;
+            }
+            return std::move(scheduledCallback.callback);
+        }
+
+        Timekeeping::Scheduler::Callback RemoveCanceledSlot(size_t slot) {
+            // A periodic callback which is being called isn't in the
+            // queue, and is freed once the call returns.
+            if (slots[slot].queuePosition == Timekeeping::NO_SLOT) {
+                return nullptr;
+            }
+            scheduledCallbacks->Remove(slot);
+            return FreeCanceledSlot(slot);
+        }
+
+        void Submit(size_t first, size_t last) {
+            auto head = submissions.load(std::memory_order_relaxed);
+            do {
+                slots[last].nextSubmission = head;
+            } while (
+                !submissions.compare_exchange_weak(head, first)
+            );
+        }
+
+        void SubmitCancellation(size_t slot) {
+            auto head = cancellations.load(std::memory_order_relaxed);
+            do {
+                slots[slot].nextCancellation = head;
+            } while (
+                !cancellations.compare_exchange_weak(
+                    head,
+                    slot,
+                    std::memory_order_release,
+                    std::memory_order_relaxed
+                )
+            );
+        }
+
+        bool ApplyRescheduledDue(size_t slot) {
+            auto& scheduledCallback = slots[slot];
+            if (scheduledCallback.rescheduledDue == Timekeeping::NO_DUE) {
+                return false;
+            }
+            scheduledCallback.due = scheduledCallback.rescheduledDue;
+            scheduledCallback.rescheduledDue = Timekeeping::NO_DUE;
+            return true;
+        }
+
+        void TakeSubmissions(
+            std::vector< size_t >& added,
+            std::vector< Timekeeping::Scheduler::Callback >& released
+        ) {
+            // The list comes out in the reverse of the order in which
+            // callbacks were scheduled, so turn it back around first.
+            // Canceled callbacks are handed back in the given vector, so
+            // that they're destroyed only after the lock is released.
+            auto slot = submissions.exchange(Timekeeping::NO_SLOT);
+            auto reversed = Timekeeping::NO_SLOT;
+            while (slot != Timekeeping::NO_SLOT) {
+                const auto next = slots[slot].nextSubmission;
+                slots[slot].nextSubmission = reversed;
+                reversed = slot;
+                slot = next;
+            }
+            added.clear();
+            for (slot = reversed; slot != Timekeeping::NO_SLOT;) {
+                auto& scheduledCallback = slots[slot];
+                const auto next = scheduledCallback.nextSubmission;
+                scheduledCallback.nextSubmission = Timekeeping::NO_SLOT;
+                scheduledCallback.submitted = true;
+                if (
+                    (scheduledCallback.status.load(std::memory_order_acquire) & Timekeeping::SLOT_CANCELED)
+                    == 0
+                ) {
+                    ApplyRescheduledDue(slot);
+                    added.push_back(slot);
+                } else if (scheduledCallback.cancellationReceived) {
+                    ReleaseCanceledSlot(slot, released);
+                }
+                slot = next;
+            }
+            if (!added.empty()) {
+                scheduledCallbacks->AddMany(added);
+            }
+        }
+
+        void TakeCancellations(std::vector< Timekeeping::Scheduler::Callback >& released) {
+            // A cancellation may be taken before the submission of the
+            // same callback, in which case the slot is left for
+            // TakeSubmissions to free.  As there, canceled callbacks are
+            // handed back in the given vector.
+            auto slot = cancellations.exchange(
+                Timekeeping::NO_SLOT,
+                std::memory_order_acquire
+            );
+            while (slot != Timekeeping::NO_SLOT) {
+                auto& scheduledCallback = slots[slot];
+                const auto next = scheduledCallback.nextCancellation;
+                scheduledCallback.nextCancellation = Timekeeping::NO_SLOT;
+                if (scheduledCallback.submitted) {
+                    if (scheduledCallback.queuePosition != Timekeeping::NO_SLOT) {
+                        scheduledCallbacks->Remove(slot);
+                    }
+                    ReleaseCanceledSlot(slot, released);
+                } else {
+                    scheduledCallback.cancellationReceived = true;
+                }
+                slot = next;
+            }
+        }
+    };
+
+    /**
+     * This counts a thread as using a shard without holding its lock, in
+     * lock-free submission mode, for as long as it exists.  Once the
+     * scheduler is shut down, it tells the thread not to use the shard,
+     * and the shard is only cleared once no thread is counted.
+     */
+    struct UnlockedShardUse {
+        // Properties
+
+        Shard& shard;
+        bool allowed;
+
+        // Lifecycle
+
+        ~UnlockedShardUse() noexcept {
+            (void)shard.unlockedUsers.fetch_sub(1, std::memory_order_release);
         }
+        UnlockedShardUse(const UnlockedShardUse&) = delete;
+        UnlockedShardUse(UnlockedShardUse&&) = delete;
+        UnlockedShardUse& operator=(const UnlockedShardUse&) = delete;
+        UnlockedShardUse& operator=(UnlockedShardUse&&) = delete;
 
+        UnlockedShardUse(
+            Shard& shard,
+            const std::atomic< bool >& shutDown
+        )
+            : shard(shard)
+        {
+            // The count and the flag are sequentially consistent, so
+            // either this sees the flag, or whoever set the flag sees
+            // the count.
+            (void)shard.unlockedUsers.fetch_add(1);
+            allowed = !shutDown.load();
+        }
     };
 
 }
@@ -39,86 +933,963 @@ namespace Timekeeping {
      * This contains the private properties of a Scheduler class instance.
      */
     struct Scheduler::Impl {
+        // Types
+
+        /**
+         * This is handed to the executor in order to call a periodic
+         * callback in place.  If the executor discards it without calling
+         * it, the call is skipped, so that the callback still comes due
+         * again, and shutting down doesn't wait for the call forever.
+         */
+        struct PeriodicCall {
+            // Properties
+
+            Impl* impl;
+            Shard* shard;
+            size_t slot;
+
+            // Lifecycle
+
+            ~PeriodicCall() noexcept {
+                if (impl != nullptr) {
+                    impl->RearmPeriodic(*shard, slot);
+                    (void)impl->periodicCalls.fetch_sub(1, std::memory_order_release);
+                }
+            }
+            PeriodicCall(const PeriodicCall&) = delete;
+            PeriodicCall(PeriodicCall&& other) noexcept
+                : impl(other.impl)
+                , shard(other.shard)
+                , slot(other.slot)
+            {
+                other.impl = nullptr;
+            }
+            PeriodicCall& operator=(const PeriodicCall&) = delete;
+            PeriodicCall& operator=(PeriodicCall&&) = delete;
+
+            PeriodicCall(
+                Impl* impl,
+                Shard* shard,
+                size_t slot
+            )
+                : impl(impl)
+                , shard(shard)
+                , slot(slot)
+            {
+            }
+
+            // Methods
+
+            void operator()() {
+                const auto callingImpl = impl;
+                impl = nullptr;
+                callingImpl->CallPeriodic(*shard, slot);
+            }
+        };
+
         // Properties
 
         std::shared_ptr< Clock > clock;
-        std::priority_queue<
-            ScheduledCallback,
-            std::vector< ScheduledCallback >,
-            std::greater< ScheduledCallback >
-        > scheduledCallbacks;
+        std::vector< std::unique_ptr< Shard > > shards;
+        size_t maxBatchSize = 1;
+        bool lockFreeSubmission = false;
+        bool preciseWaiting = false;
+        std::chrono::steady_clock::duration spinTime{0};
+        std::shared_ptr< Executor > executor;
         std::thread worker;
-        std::condition_variable_any wakeWorker;
+        std::mutex wakeMutex;
+        std::condition_variable wakeWorker;
+        std::atomic< bool > wakeRequested{false};
+        std::atomic< int64_t > sleepingUntil{INT64_MAX};
         bool stopWorker = false;
-        std::recursive_mutex mutex;
-        int nextToken = 1;
-        std::map< int, bool > isCallbackCanceled;
+        bool threadless = false;
+        std::function< void() > deadlineChanged;
+        std::unique_ptr< PollDescriptor > pollDescriptor;
+        std::vector< DueCallback > threadlessBatch;
+        std::vector< size_t > threadlessSubmitted;
+        std::atomic< uint64_t > wakeUps{0};
+        std::atomic< uint64_t > usefulWakeUps{0};
+        std::atomic< uint64_t > fired{0};
+        Histogram lateness;
+        bool measureCallbackTime = false;
+        Histogram callbackTime;
+        std::chrono::nanoseconds slowCallbackThreshold{0};
+        ProblemReporter slowCallback;
+        std::chrono::nanoseconds watchdogTimeout{0};
+        ProblemReporter workerStalled;
+        bool watched = false;
+        std::thread watchdog;
+        std::mutex watchdogMutex;
+        std::condition_variable wakeWatchdog;
+        bool stopWatchdog = false;
+        std::mutex runningMutex;
+        int64_t runningSince = 0;
+        Token runningToken = 0;
+        const char* runningSite = nullptr;
+        std::atomic< int64_t > wakeDeadline{INT64_MAX};
+        std::shared_ptr< Tracer > tracer;
+        std::atomic< bool > shutDown{false};
+        std::atomic< size_t > periodicCalls{0};
+        bool orphaned = false;
+        std::mutex callbackFactoriesMutex;
+        std::unordered_map< uint32_t, CallbackFactory > callbackFactories;
 
         // Lifecycle
 
         ~Impl() noexcept {
-            if (!worker.joinable()) {
-                return;
-            }
-            std::unique_lock< decltype(mutex) > lock(mutex);
-            stopWorker = true;
-            wakeWorker.notify_all();
-            lock.unlock();
-            worker.join();
+            StopThreads();
+            executor = nullptr;
         }
         Impl(const Impl&) noexcept = delete;
         Impl(Impl&&) = default;
         Impl& operator=(const Impl&) = delete;
         Impl& operator=(Impl&&) = default;
 
+        // This is used in place of deleting the instance when the last
+        // scheduler sharing it is destroyed.  If that happens on the
+        // worker thread, such as in a callback which destroys its own
+        // scheduler, the worker thread can't be joined, so it's told to
+        // stop and detached instead, and deletes the instance itself
+        // once it's done with it.
+        static void Destroy(Impl* impl) {
+            if (
+                impl->worker.joinable()
+                && (impl->worker.get_id() == std::this_thread::get_id())
+            ) {
+                std::lock_guard< decltype(impl->wakeMutex) > lock(impl->wakeMutex);
+                impl->stopWorker = true;
+                impl->orphaned = true;
+                impl->worker.detach();
+                return;
+            }
+            delete impl;
+        }
+
         // Methods
 
-        Impl() {
-            worker = std::thread(&Impl::Worker, this);
-        }
+        void StopThreads() {
+            if (watchdog.joinable()) {
+                std::unique_lock< decltype(watchdogMutex) > lock(watchdogMutex);
+                stopWatchdog = true;
+                wakeWatchdog.notify_all();
+                lock.unlock();
+                watchdog.join();
+            }
+            if (worker.joinable()) {
+                std::unique_lock< decltype(wakeMutex) > lock(wakeMutex);
+                stopWorker = true;
+                wakeWorker.notify_all();
+                lock.unlock();
 
-        void Worker() {
-            std::unique_lock< decltype(mutex) > lock(mutex);
-            while (!stopWorker) {
-                if (scheduledCallbacks.empty()) {
-                    wakeWorker.wait(lock);
-                } else {
-                    const auto& nextInSchedule = scheduledCallbacks.top();
-                    const auto now = clock->GetCurrentTime();
-                    const auto waitTimeSeconds = nextInSchedule.due - now;
-                    const auto isNotCanceled = !isCallbackCanceled[nextInSchedule.token];
-                    if (
-                        (waitTimeSeconds > 0)
-                        && isNotCanceled
-                    ) {
-                        wakeWorker.wait_for(
-                            lock,
-                            std::chrono::milliseconds(
-                                (int)ceil(waitTimeSeconds * 1000.0)
-                            )
-                        );
-                    } else if (isNotCanceled) {
-                        auto callback = nextInSchedule.callback;
-                        (void)isCallbackCanceled.erase(nextInSchedule.token);
-                        scheduledCallbacks.pop();
-                        lock.unlock();
-                        callback();
-                        lock.lock();
-                    } else {
-                        (void)isCallbackCanceled.erase(nextInSchedule.token);
-                        scheduledCallbacks.pop();
-                    }
+                // A callback may stop the threads of its own scheduler,
+                // in which case the worker thread stops once the callback
+                // returns, and is joined when the scheduler is destroyed.
+                if (worker.get_id() != std::this_thread::get_id()) {
+                    worker.join();
                 }
             }
         }
-    };
 
-    Scheduler::~Scheduler() noexcept = default;
-    Scheduler::Scheduler(Scheduler&&) noexcept = default;
-    Scheduler& Scheduler::operator=(Scheduler&& other) noexcept = default;
+        explicit Impl(const Configuration& configuration)
+            : maxBatchSize(std::max((size_t)1, configuration.maxBatchSize))
+            , lockFreeSubmission(configuration.lockFreeSubmission)
+            , preciseWaiting(configuration.preciseWaiting)
+            , spinTime(
+                std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                    std::chrono::duration< double >(
+                        std::max(0.0, std::min(1.0, configuration.spinTime))
+                    )
+                )
+            )
+            , threadless(configuration.threadless)
+            , deadlineChanged(configuration.deadlineChanged)
+            , measureCallbackTime(configuration.measureCallbackTime)
+            , workerStalled(configuration.workerStalled)
+            , tracer(configuration.tracer)
+        {
+            const auto numShards = std::min(
+                MAX_SHARDS,
+                std::max((size_t)1, configuration.shards)
+            );
+            for (size_t i = 0; i < numShards; ++i) {
+                std::unique_ptr< Shard > shard(new Shard());
+                shard->index = i;
+                switch (configuration.backend) {
+                    case Backend::TimingWheel: {
+                        shard->scheduledCallbacks.reset(
+                            new TimingWheel(shard->slots, configuration.tickResolution)
+                        );
+                    } break;
+
+                    case Backend::Heap:
+                    default: {
+                        shard->scheduledCallbacks.reset(new TimerHeap(shard->slots));
+                    } break;
+                }
+                shards.push_back(std::move(shard));
+            }
+            executor = configuration.executor;
+            if (executor == nullptr) {
+                if (configuration.callbackThreads > 0) {
+                    executor = std::make_shared< ThreadPool >(
+                        configuration.callbackThreads
+                    );
+                } else {
+                    executor = std::make_shared< InlineExecutor >();
+                }
+            }
+            clock = std::make_shared< SteadyClock >();
+            if (
+                (configuration.slowCallbackThreshold > 0.0)
+                && (configuration.slowCallback != nullptr)
+            ) {
+                slowCallbackThreshold = ToNanoseconds(
+                    configuration.slowCallbackThreshold
+                );
+                slowCallback = configuration.slowCallback;
+            }
+            if (
+                !threadless
+                && (configuration.watchdogTimeout > 0.0)
+                && (workerStalled != nullptr)
+            ) {
+                watchdogTimeout = ToNanoseconds(configuration.watchdogTimeout);
+                watched = true;
+            }
+            if (threadless) {
+                threadlessBatch.reserve(maxBatchSize * shards.size());
+                if (configuration.pollable) {
+                    pollDescriptor.reset(new PollDescriptor());
+                }
+            } else {
+                worker = std::thread(&Impl::RunWorker, this);
+                if (watched) {
+                    watchdog = std::thread(&Impl::Watchdog, this);
+                }
+            }
+        }
+
+        void TraceScheduled(Token token, int64_t due) {
+            if (
+                TRACING
+                && (tracer != nullptr)
+            ) {
+                tracer->Scheduled(token, due);
+            }
+        }
+
+        void TraceCanceled(Token token) {
+            if (
+                TRACING
+                && (tracer != nullptr)
+            ) {
+                tracer->Canceled(token);
+            }
+        }
+
+        Shard& GetCurrentThreadShard() {
+            return *shards[threadNumber % shards.size()];
+        }
+
+        Shard* GetTokenShard(Token token) {
+            const auto index = (size_t)((token >> TOKEN_SLOT_BITS) & TOKEN_SHARD_MASK);
+            if (index >= shards.size()) {
+                return nullptr;
+            }
+            return shards[index].get();
+        }
+
+        void WakeWorker() {
+            // The lock only needs to be taken by whichever thread sets
+            // the flag, and only so that the worker can't miss the
+            // notification between checking the flag and waiting.
+            // In threadless mode, the owner of the scheduler is told
+            // instead, at most once per deadline it's given.
+            if (threadless) {
+                if (!wakeRequested.exchange(true)) {
+                    if (pollDescriptor != nullptr) {
+                        pollDescriptor->Signal();
+                    }
+                    if (deadlineChanged != nullptr) {
+                        deadlineChanged();
+                    }
+                }
+                return;
+            }
+            if (!wakeRequested.exchange(true)) {
+                std::lock_guard< decltype(wakeMutex) > lock(wakeMutex);
+                wakeWorker.notify_one();
+            }
+        }
+
+        void WakeWorkerIfSooner(int64_t due) {
+            // While the worker is awake, this is infinite, so the worker
+            // is always told to look again, in case it already looked
+            // before the callback was scheduled.  Submitting a callback
+            // and reading this are sequentially consistent for the same
+            // reason.
+            if (due < sleepingUntil) {
+                WakeWorker();
+            }
+        }
+
+        int64_t GetNextPeriodicDue(const ScheduledCallback& scheduledCallback) {
+            const auto currentClock = clock;
+            const auto now = (
+                (currentClock == nullptr)
+                ? scheduledCallback.requestedDue
+                : currentClock->GetCurrentTicks()
+            );
+            const auto interval = scheduledCallback.interval;
+            if (scheduledCallback.periodicMode == PeriodicMode::FixedDelay) {
+                return AddTicks(now, interval);
+            }
+            auto due = AddTicks(scheduledCallback.requestedDue, interval);
+            if (
+                (scheduledCallback.catchUp == CatchUp::SkipMissedPeriods)
+                && (due <= now)
+            ) {
+                // Move to the latest due time on the grid which isn't
+                // in the future, so the callback is called once more
+                // for all the missed periods.
+                const auto missedPeriods = (now - due) / interval;
+                if (missedPeriods > INT64_MAX / interval) {
+                    return INT64_MAX;
+                }
+                due = AddTicks(due, missedPeriods * interval);
+            }
+            return due;
+        }
+
+        void RearmPeriodic(Shard& shard, size_t slot) {
+            // The slot isn't in the timer queue while its callback is
+            // being called, so it's put back here, unless it was canceled
+            // in the meantime.
+            auto& scheduledCallback = shard.slots[slot];
+            Callback callback;
+            std::unique_lock< decltype(shard.mutex) > lock(shard.mutex);
+            if (
+                shutDown
+                && shard.MarkSlotCanceled(slot)
+                && lockFreeSubmission
+            ) {
+                shard.SubmitCancellation(slot);
+            }
+            const auto canceled = (
+                (scheduledCallback.status.load(std::memory_order_acquire) & SLOT_CANCELED)
+                != 0
+            );
+            if (
+                !canceled
+                && !shard.ApplyRescheduledDue(slot)
+            ) {
+                scheduledCallback.requestedDue = GetNextPeriodicDue(scheduledCallback);
+                scheduledCallback.due = ApplySlack(
+                    scheduledCallback.requestedDue,
+                    scheduledCallback.slack
+                );
+            }
+            const auto due = scheduledCallback.due;
+            if (lockFreeSubmission) {
+                lock.unlock();
+                shard.Submit(slot, slot);
+            } else if (canceled) {
+                callback = shard.FreeCanceledSlot(slot);
+                return;
+            } else {
+                shard.scheduledCallbacks->Add(slot);
+                lock.unlock();
+            }
+            WakeWorkerIfSooner(due);
+        }
+
+        void CallPeriodic(Shard& shard, size_t slot) {
+            shard.slots[slot].callback();
+            RearmPeriodic(shard, slot);
+            (void)periodicCalls.fetch_sub(1, std::memory_order_release);
+        }
+
+        void WaitPrecisely(
+            std::unique_lock< std::mutex >& wakeLock,
+            std::chrono::steady_clock::time_point sampled,
+            int64_t waitTicks
+        ) {
+            // Clock ticks are nanoseconds.
+            const auto deadline = sampled + std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                std::chrono::nanoseconds(
+                    std::max(MIN_PRECISE_WAIT, std::min(MAX_WAIT, waitTicks))
+                )
+            );
+            const auto spinStart = deadline - spinTime;
+            if (std::chrono::steady_clock::now() < spinStart) {
+                (void)wakeWorker.wait_until(wakeLock, spinStart);
+            }
+            if (
+                (spinTime.count() > 0)
+                && !wakeRequested
+                && !stopWorker
+                && (std::chrono::steady_clock::now() >= spinStart)
+            ) {
+                wakeLock.unlock();
+                while (
+                    !wakeRequested
+                    && (std::chrono::steady_clock::now() < deadline)
+                ) {
+                    CpuRelax();
+                }
+                wakeLock.lock();
+            }
+        }
+
+        bool TakeDueCallbacks(
+            std::vector< DueCallback >& batch,
+            std::vector< size_t >& submitted,
+            bool& sampledClock,
+            int64_t& now,
+            std::chrono::steady_clock::time_point& sampled,
+            int64_t& nextDue
+        ) {
+            // Take the callbacks which are due from each shard in turn,
+            // and find out when the next one is due.  The clock is only
+            // sampled if it's needed and wasn't sampled already.  Without
+            // a clock, nothing can be due, so the callbacks are left where
+            // they are.  Canceled callbacks are destroyed only once no
+            // shard is locked.
+            std::vector< Callback > released;
+            auto haveNextDue = false;
+            for (auto& shard: shards) {
+                std::lock_guard< decltype(shard->mutex) > shardLock(shard->mutex);
+                if (lockFreeSubmission) {
+                    shard->TakeSubmissions(submitted, released);
+                    shard->TakeCancellations(released);
+                }
+                auto& scheduledCallbacks = *shard->scheduledCallbacks;
+                if (scheduledCallbacks.IsEmpty()) {
+                    continue;
+                }
+                if (!sampledClock) {
+                    const auto currentClock = clock;
+                    if (currentClock == nullptr) {
+                        continue;
+                    }
+                    now = currentClock->GetCurrentTicks();
+                    sampled = std::chrono::steady_clock::now();
+                    sampledClock = true;
+                }
+                size_t nextInSchedule;
+                size_t taken = 0;
+                while (
+                    (taken < maxBatchSize)
+                    && scheduledCallbacks.PopDue(now, nextInSchedule)
+                ) {
+                    // A callback canceled after being submitted, whose
+                    // cancellation hasn't been taken yet, is left for
+                    // TakeCancellations to free.
+                    auto& scheduledCallback = shard->slots[nextInSchedule];
+                    if (shard->ApplyRescheduledDue(nextInSchedule)) {
+                        // The callback was rescheduled to a later time
+                        // without moving it, so move it now.
+                        scheduledCallbacks.Add(nextInSchedule);
+                        continue;
+                    }
+                    if (scheduledCallback.interval != 0) {
+                        // Periodic callbacks are called in place, and
+                        // keep their slot, so they're called through a
+                        // task which puts them back afterwards.
+                        if (
+                            (scheduledCallback.status.load(std::memory_order_acquire) & SLOT_CANCELED)
+                            != 0
+                        ) {
+                            continue;
+                        }
+                        scheduledCallback.submitted = false;
+                        DueCallback dueCallback;
+                        dueCallback.due = scheduledCallback.due;
+                        dueCallback.strand = scheduledCallback.strand;
+                        dueCallback.token = shard->MakeToken(nextInSchedule);
+                        dueCallback.site = scheduledCallback.site;
+                        dueCallback.callback = PeriodicCall(this, shard.get(), nextInSchedule);
+                        (void)periodicCalls.fetch_add(1, std::memory_order_relaxed);
+                        batch.push_back(std::move(dueCallback));
+                        ++taken;
+                        continue;
+                    }
+                    // The token is made before the slot is marked as
+                    // called, since that moves the slot to its next
+                    // generation.
+                    const auto token = shard->MakeToken(nextInSchedule);
+                    if (!shard->MarkCalled(nextInSchedule)) {
+                        continue;
+                    }
+                    DueCallback dueCallback;
+                    dueCallback.due = scheduledCallback.due;
+                    dueCallback.strand = scheduledCallback.strand;
+                    dueCallback.token = token;
+                    dueCallback.site = scheduledCallback.site;
+                    dueCallback.callback = shard->FreeSlot(nextInSchedule);
+                    batch.push_back(std::move(dueCallback));
+                    ++taken;
+                }
+                if (!scheduledCallbacks.IsEmpty()) {
+                    const auto shardNextDue = scheduledCallbacks.GetNextDue();
+                    if (
+                        !haveNextDue
+                        || (shardNextDue < nextDue)
+                    ) {
+                        nextDue = shardNextDue;
+                    }
+                    haveNextDue = true;
+                }
+            }
+            return haveNextDue;
+        }
+
+        void CallDueCallbacks(
+            std::vector< DueCallback >& batch,
+            int64_t now
+        ) {
+            // Callbacks taken from different shards are merged into the
+            // order they became due.
+            if (shards.size() > 1) {
+                std::stable_sort(
+                    batch.begin(),
+                    batch.end(),
+                    [](const DueCallback& lhs, const DueCallback& rhs){
+                        return lhs.due < rhs.due;
+                    }
+                );
+            }
+            (void)fired.fetch_add(batch.size(), std::memory_order_relaxed);
+            const auto traced = (
+                TRACING
+                && (tracer != nullptr)
+            );
+            const auto timed = (
+                measureCallbackTime
+                || (slowCallback != nullptr)
+                || watched
+            );
+            for (auto& dueCallback: batch) {
+                lateness.Record(
+                    (now > dueCallback.due)
+                    ? (uint64_t)now - (uint64_t)dueCallback.due
+                    : 0
+                );
+                if (traced) {
+                    tracer->CallbackStarting(dueCallback.token, dueCallback.due);
+                }
+                if (timed) {
+                    ExecuteTimed(dueCallback);
+                } else {
+                    executor->Execute(
+                        std::move(dueCallback.callback),
+                        dueCallback.strand
+                    );
+                }
+                if (traced) {
+                    tracer->CallbackFinished(dueCallback.token);
+                }
+            }
+            batch.clear();
+        }
+
+        void ExecuteTimed(DueCallback& dueCallback) {
+            const auto start = GetSteadyNanoseconds();
+            if (watched) {
+                std::lock_guard< decltype(runningMutex) > lock(runningMutex);
+                runningSince = start;
+                runningToken = dueCallback.token;
+                runningSite = dueCallback.site;
+            }
+            executor->Execute(
+                std::move(dueCallback.callback),
+                dueCallback.strand
+            );
+            const auto duration = std::chrono::nanoseconds(
+                GetSteadyNanoseconds() - start
+            );
+            if (watched) {
+                std::lock_guard< decltype(runningMutex) > lock(runningMutex);
+                runningSince = 0;
+            }
+            if (measureCallbackTime) {
+                callbackTime.Record((uint64_t)duration.count());
+            }
+            if (
+                (slowCallback != nullptr)
+                && (duration > slowCallbackThreshold)
+            ) {
+                slowCallback(dueCallback.token, dueCallback.site, duration);
+            }
+        }
+
+        void Watchdog() {
+            // Each stall is reported only once, which is told by the time
+            // the worker started the callback it's stuck in, or the time
+            // it should have woken up.
+            int64_t reportedRunningSince = 0;
+            auto reportedWakeDeadline = INT64_MAX;
+            const auto timeout = (int64_t)watchdogTimeout.count();
+            std::unique_lock< decltype(watchdogMutex) > lock(watchdogMutex);
+            while (!stopWatchdog) {
+                (void)wakeWatchdog.wait_for(lock, watchdogTimeout / 2);
+                if (stopWatchdog) {
+                    break;
+                }
+                const auto now = GetSteadyNanoseconds();
+                std::unique_lock< decltype(runningMutex) > runningLock(runningMutex);
+                const auto since = runningSince;
+                const auto token = runningToken;
+                const auto site = runningSite;
+                runningLock.unlock();
+                Token stalledToken = 0;
+                const char* stalledSite = nullptr;
+                int64_t stalledSince;
+                if (since != 0) {
+                    if (
+                        (since == reportedRunningSince)
+                        || (now - since <= timeout)
+                    ) {
+                        continue;
+                    }
+                    reportedRunningSince = since;
+                    stalledToken = token;
+                    stalledSite = site;
+                    stalledSince = since;
+                } else {
+                    const auto deadline = wakeDeadline.load(std::memory_order_relaxed);
+                    if (
+                        (deadline == INT64_MAX)
+                        || (deadline == reportedWakeDeadline)
+                        || (now - deadline <= timeout)
+                    ) {
+                        continue;
+                    }
+                    reportedWakeDeadline = deadline;
+                    stalledSince = deadline;
+                }
+                lock.unlock();
+                workerStalled(
+                    stalledToken,
+                    stalledSite,
+                    std::chrono::nanoseconds(now - stalledSince)
+                );
+                lock.lock();
+            }
+        }
+
+        void RunWorker() {
+            Worker();
+            if (orphaned) {
+                delete this;
+            }
+        }
+
+        void Worker() {
+            std::vector< DueCallback > batch;
+            batch.reserve(maxBatchSize * shards.size());
+            std::vector< size_t > submitted;
+            auto wokeUp = false;
+            std::unique_lock< decltype(wakeMutex) > wakeLock(wakeMutex);
+            while (!stopWorker) {
+                // Clearing the flag with an exchange, rather than a
+                // plain store, ensures that everything submitted before
+                // the flag was last set is seen below.
+                (void)wakeRequested.exchange(false);
+                sleepingUntil = INT64_MAX;
+                if (watched) {
+                    wakeDeadline.store(INT64_MAX, std::memory_order_relaxed);
+                }
+                wakeLock.unlock();
+
+                auto sampledClock = false;
+                int64_t now = 0;
+                std::chrono::steady_clock::time_point sampled;
+                int64_t nextDue = 0;
+                const auto haveNextDue = TakeDueCallbacks(
+                    batch,
+                    submitted,
+                    sampledClock,
+                    now,
+                    sampled,
+                    nextDue
+                );
+
+                if (wokeUp) {
+                    (void)wakeUps.fetch_add(1, std::memory_order_relaxed);
+                    if (!batch.empty()) {
+                        (void)usefulWakeUps.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    wokeUp = false;
+                }
+
+                // Call the callbacks which are due.
+                if (!batch.empty()) {
+                    CallDueCallbacks(batch, now);
+                    wakeLock.lock();
+                    continue;
+                }
+
+                // Wait until the next callback is due, or something
+                // is scheduled.
+                wakeLock.lock();
+                if (haveNextDue) {
+                    sleepingUntil = nextDue;
+                    if (watched) {
+                        // Clock ticks are nanoseconds.
+                        wakeDeadline.store(
+                            (int64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                sampled.time_since_epoch()
+                            ).count() + std::min(MAX_WAIT, nextDue - now),
+                            std::memory_order_relaxed
+                        );
+                    }
+                }
+                if (
+                    wakeRequested
+                    || stopWorker
+                ) {
+                    continue;
+                }
+                wokeUp = true;
+                if (
+                    haveNextDue
+                    && preciseWaiting
+                ) {
+                    // Waiting until a deadline measured from when the
+                    // clock was sampled, rather than for a length of
+                    // time from now, keeps the time taken to get here
+                    // from making the callback late.
+                    WaitPrecisely(wakeLock, sampled, nextDue - now);
+                } else if (haveNextDue) {
+                    // The timing wheel may ask to be woken up at the
+                    // start of a tick which, due to rounding, is not
+                    // quite reached yet, so always wait at least a
+                    // little while to avoid spinning.
+                    const auto waitTicks = std::min(MAX_WAIT, nextDue - now);
+                    wakeWorker.wait_for(
+                        wakeLock,
+                        std::chrono::milliseconds(
+                            std::max(
+                                (int64_t)1,
+                                (waitTicks + TICKS_PER_MILLISECOND - 1) / TICKS_PER_MILLISECOND
+                            )
+                        )
+                    );
+                } else {
+                    wakeWorker.wait(wakeLock);
+                }
+            }
+        }
+
+        void CallRemainingCallbacks(
+            bool drain,
+            std::chrono::nanoseconds drainTime
+        ) {
+            // This is called on the thread shutting down the scheduler,
+            // once the worker thread has stopped.  Without draining, the
+            // clock is sampled only once, so that only the callbacks
+            // already due are called.  Without a clock, none are.
+            const auto currentClock = clock;
+            if (currentClock == nullptr) {
+                return;
+            }
+            std::vector< DueCallback > batch;
+            std::vector< size_t > submitted;
+            const auto start = currentClock->GetCurrentTicks();
+            const auto drainTicks = std::max((int64_t)0, (int64_t)drainTime.count());
+            const auto lastDue = drain ? AddTicks(start, drainTicks) : start;
+            const auto drainUntil = (
+                std::chrono::steady_clock::now()
+                + std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                    std::chrono::nanoseconds(drainTicks)
+                )
+            );
+            for (;;) {
+                auto sampledClock = !drain;
+                auto now = start;
+                std::chrono::steady_clock::time_point sampled;
+                int64_t nextDue = 0;
+                const auto haveNextDue = TakeDueCallbacks(
+                    batch,
+                    submitted,
+                    sampledClock,
+                    now,
+                    sampled,
+                    nextDue
+                );
+                if (!batch.empty()) {
+                    CallDueCallbacks(batch, now);
+                    continue;
+                }
+                if (
+                    !haveNextDue
+                    || (nextDue > lastDue)
+                ) {
+                    break;
+                }
+                const auto remaining = drainUntil - std::chrono::steady_clock::now();
+                if (remaining.count() <= 0) {
+                    break;
+                }
+                // Clock ticks are nanoseconds.
+                std::this_thread::sleep_for(
+                    std::min(
+                        remaining,
+                        std::chrono::duration_cast< std::chrono::steady_clock::duration >(
+                            std::chrono::nanoseconds(std::min(MAX_WAIT, nextDue - now))
+                        )
+                    )
+                );
+            }
+        }
+
+        size_t DropCallbacks() {
+            // Periodic callbacks still being called by the executor are
+            // in their slots, and threads scheduling or canceling
+            // callbacks without the lock may still be looking at slots,
+            // so they're waited for before the slots are released.  The
+            // dropped callbacks are destroyed only once no shard is
+            // locked.
+            while (periodicCalls.load(std::memory_order_acquire) > 0) {
+                std::this_thread::yield();
+            }
+            size_t dropped = 0;
+            std::vector< Callback > released;
+            for (auto& shard: shards) {
+                while (shard->unlockedUsers.load() > 0) {
+                    std::this_thread::yield();
+                }
+                std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+                dropped += (size_t)shard->pending.load(std::memory_order_relaxed);
+                shard->Clear(released);
+            }
+            released.clear();
+            return dropped;
+        }
+    };
+
+    /**
+     * This keeps track of the callbacks scheduled through one of the
+     * schedulers sharing a timer service, so that the scheduler can only
+     * cancel its own callbacks, and can cancel all of them when it's
+     * destroyed.
+     *
+     * Callbacks aren't wrapped in order to be forgotten once they're
+     * called.  Instead, tokens of callbacks which are no longer scheduled
+     * are pruned whenever the number of tokens kept doubles, so that
+     * keeping track of a callback costs a single set entry.
+     */
+    struct Scheduler::Handle {
+        // Properties
+
+        /**
+         * This is used to schedule and cancel callbacks with the engine
+         * shared by all the schedulers of the timer service, without
+         * keeping track of them.
+         *
+         * It doesn't own the engine.  The scheduler holding the handle
+         * does, so that the handle never ends up destroying the engine.
+         */
+        Scheduler engine;
+
+        std::mutex mutex;
+        std::unordered_set< Token > tokens;
+        size_t pruneAt = MIN_TRACKED_TOKENS_TO_PRUNE;
+
+        // Methods
+
+        explicit Handle(const std::shared_ptr< Impl >& impl)
+            : engine(std::shared_ptr< Impl >(std::shared_ptr< Impl >(), impl.get()), false)
+        {
+        }
+
+        // This must be called while holding the mutex.
+        void Remember(Token token) {
+            if (token == 0) {
+                return;
+            }
+            (void)tokens.insert(token);
+            if (tokens.size() >= pruneAt) {
+                Prune();
+                pruneAt = std::max(MIN_TRACKED_TOKENS_TO_PRUNE, 2 * tokens.size());
+            }
+        }
+
+        // This must be called while holding the mutex.
+        void Prune() {
+            for (auto tokensEntry = tokens.begin(); tokensEntry != tokens.end();) {
+                if (IsScheduled(*tokensEntry)) {
+                    ++tokensEntry;
+                } else {
+                    tokensEntry = tokens.erase(tokensEntry);
+                }
+            }
+        }
+
+        bool IsScheduled(Token token) {
+            const auto shard = engine.impl_->GetTokenShard(token);
+            if (shard == nullptr) {
+                return false;
+            }
+            std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+            size_t slot;
+            return shard->FindScheduled(token, slot);
+        }
+
+        // This must be called while holding the mutex.
+        bool Release(Token token) {
+            return (tokens.erase(token) > 0);
+        }
+    };
+
+    Scheduler::~Scheduler() noexcept {
+        CancelTrackedCallbacks();
+    }
+
+    Scheduler::Scheduler(Scheduler&&) noexcept = default;
+
+    Scheduler& Scheduler::operator=(Scheduler&& other) noexcept {
+        if (this != &other) {
+            CancelTrackedCallbacks();
+            impl_ = std::move(other.impl_);
+            handle_ = std::move(other.handle_);
+        }
+        return *this;
+    }
+
+    Scheduler::Scheduler(
+        std::shared_ptr< Impl > impl,
+        bool tracked
+    )
+        : impl_(std::move(impl))
+    {
+        if (tracked) {
+            handle_ = std::make_shared< Handle >(impl_);
+        }
+    }
+
+    void Scheduler::CancelTrackedCallbacks() {
+        if (handle_ == nullptr) {
+            return;
+        }
+        std::unique_lock< decltype(handle_->mutex) > lock(handle_->mutex);
+        const std::vector< Token > tokens(
+            handle_->tokens.begin(),
+            handle_->tokens.end()
+        );
+        handle_->tokens.clear();
+        lock.unlock();
+        handle_->engine.CancelMany(tokens);
+    }
 
     Scheduler::Scheduler()
-        : impl_(new Impl())
+        : impl_(new Impl(Configuration()), Impl::Destroy)
+    {
+    }
+
+    Scheduler::Scheduler(const Configuration& configuration)
+        : impl_(new Impl(configuration), Impl::Destroy)
     {
     }
 
@@ -130,36 +1901,686 @@ namespace Timekeeping {
         impl_->clock = clock;
     }
 
-    int Scheduler::Schedule(
+    auto Scheduler::Schedule(
         Callback callback,
-        double due
-    ) {
+        double due,
+        double slack
+    ) -> Token {
+        return Schedule(
+            std::move(callback),
+            std::chrono::nanoseconds(Clock::SecondsToTicks(due)),
+            std::chrono::nanoseconds(Clock::SecondsToTicks(slack))
+        );
+    }
+
+    auto Scheduler::Schedule(
+        Callback callback,
+        std::chrono::nanoseconds due,
+        std::chrono::nanoseconds slack
+    ) -> Token {
+        ScheduleRequest request;
+        request.callback = std::move(callback);
+        request.due = due;
+        request.slack = slack;
+        return Schedule(std::move(request));
+    }
+
+    auto Scheduler::SchedulePeriodic(
+        Callback callback,
+        std::chrono::nanoseconds firstDue,
+        std::chrono::nanoseconds interval,
+        PeriodicMode periodicMode,
+        CatchUp catchUp
+    ) -> Token {
+        if (interval.count() <= 0) {
+            return 0;
+        }
+        ScheduleRequest request;
+        request.callback = std::move(callback);
+        request.due = firstDue;
+        request.interval = interval;
+        request.periodicMode = periodicMode;
+        request.catchUp = catchUp;
+        return Schedule(std::move(request));
+    }
+
+    auto Scheduler::SchedulePeriodic(
+        Callback callback,
+        double firstDue,
+        double interval,
+        PeriodicMode periodicMode,
+        CatchUp catchUp
+    ) -> Token {
+        return SchedulePeriodic(
+            std::move(callback),
+            std::chrono::nanoseconds(Clock::SecondsToTicks(firstDue)),
+            std::chrono::nanoseconds(Clock::SecondsToTicks(interval)),
+            periodicMode,
+            catchUp
+        );
+    }
+
+    auto Scheduler::ScheduleAfter(
+        Callback callback,
+        std::chrono::nanoseconds delay,
+        std::chrono::nanoseconds slack
+    ) -> Token {
         if (impl_->clock == nullptr) {
             return 0;
         }
-        ScheduledCallback scheduledCallback;
-        scheduledCallback.callback = callback;
-        scheduledCallback.due = due;
-        std::lock_guard< decltype(impl_->mutex) > lock(impl_->mutex);
-        const auto token = impl_->nextToken++;
-        impl_->isCallbackCanceled[token] = false;
-        scheduledCallback.token = token;
-        impl_->scheduledCallbacks.push(std::move(scheduledCallback));
-        impl_->wakeWorker.notify_one();
+        const auto now = impl_->clock->GetCurrentTicks();
+        const auto delayTicks = std::max((int64_t)0, (int64_t)delay.count());
+        return Schedule(
+            std::move(callback),
+            std::chrono::nanoseconds(
+                (now > INT64_MAX - delayTicks)
+                ? INT64_MAX
+                : now + delayTicks
+            ),
+            slack
+        );
+    }
+
+    auto Scheduler::Schedule(ScheduleRequest request) -> Token {
+        if (handle_ != nullptr) {
+            std::lock_guard< decltype(handle_->mutex) > lock(handle_->mutex);
+            const auto token = handle_->engine.Schedule(std::move(request));
+            handle_->Remember(token);
+            return token;
+        }
+        if (
+            (impl_->clock == nullptr)
+            || impl_->shutDown
+        ) {
+            return 0;
+        }
+        const auto due = ApplySlack(request.due.count(), request.slack.count());
+        auto& shard = impl_->GetCurrentThreadShard();
+        if (impl_->lockFreeSubmission) {
+            const UnlockedShardUse use(shard, impl_->shutDown);
+            if (!use.allowed) {
+                return 0;
+            }
+            const auto slot = shard.PrepareSlot(std::move(request));
+            if (slot == NO_SLOT) {
+                return 0;
+            }
+            const auto token = shard.MakeToken(slot);
+            impl_->TraceScheduled(token, due);
+            shard.Submit(slot, slot);
+            impl_->WakeWorkerIfSooner(due);
+            return token;
+        }
+        std::unique_lock< decltype(shard.mutex) > lock(shard.mutex);
+        const auto slot = shard.PrepareSlot(std::move(request));
+        if (slot == NO_SLOT) {
+            return 0;
+        }
+        shard.scheduledCallbacks->Add(slot);
+        const auto token = shard.MakeToken(slot);
+        impl_->TraceScheduled(token, due);
+        lock.unlock();
+        impl_->WakeWorkerIfSooner(due);
         return token;
     }
 
-    void Scheduler::Cancel(int token) {
-        std::lock_guard< decltype(impl_->mutex) > lock(impl_->mutex);
-        auto isCallbackCanceledEntry = impl_->isCallbackCanceled.find(token);
-        if (isCallbackCanceledEntry != impl_->isCallbackCanceled.end()) {
-            isCallbackCanceledEntry->second = true;
+    bool Scheduler::Cancel(Token token) {
+        if (handle_ != nullptr) {
+            std::unique_lock< decltype(handle_->mutex) > lock(handle_->mutex);
+            if (!handle_->Release(token)) {
+                return false;
+            }
+            lock.unlock();
+            return handle_->engine.Cancel(token);
+        }
+        // The canceled callback is moved here so that it's destroyed
+        // only after the lock is released, in case destroying it
+        // causes the scheduler to be used again.
+        Callback callback;
+        const auto shard = impl_->GetTokenShard(token);
+        if (shard == nullptr) {
+            return false;
+        }
+        size_t slot;
+        if (impl_->lockFreeSubmission) {
+            const UnlockedShardUse use(*shard, impl_->shutDown);
+            if (
+                !use.allowed
+                || !shard->MarkCanceled(token, slot)
+            ) {
+                return false;
+            }
+            impl_->TraceCanceled(token);
+            callback = shard->TakeCanceledCallback(slot);
+            shard->SubmitCancellation(slot);
+            impl_->WakeWorker();
+            return true;
+        }
+        std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+        if (!shard->MarkCanceled(token, slot)) {
+            return false;
+        }
+        impl_->TraceCanceled(token);
+        callback = shard->RemoveCanceledSlot(slot);
+        return true;
+    }
+
+    bool Scheduler::Reschedule(
+        Token token,
+        std::chrono::nanoseconds due
+    ) {
+        if (handle_ != nullptr) {
+            std::unique_lock< decltype(handle_->mutex) > lock(handle_->mutex);
+            if (handle_->tokens.find(token) == handle_->tokens.end()) {
+                return false;
+            }
+            lock.unlock();
+            return handle_->engine.Reschedule(token, due);
+        }
+        const auto shard = impl_->GetTokenShard(token);
+        if (shard == nullptr) {
+            return false;
+        }
+        std::unique_lock< decltype(shard->mutex) > lock(shard->mutex);
+        size_t slot;
+        if (!shard->FindScheduled(token, slot)) {
+            return false;
+        }
+        auto& scheduledCallback = shard->slots[slot];
+        scheduledCallback.requestedDue = due.count();
+        const auto newDue = ApplySlack(
+            scheduledCallback.requestedDue,
+            scheduledCallback.slack
+        );
+        if (scheduledCallback.queuePosition == NO_SLOT) {
+            // The callback hasn't been put into the timer queue yet, or
+            // is periodic and being called, so its new due time takes
+            // effect once it's put into the queue.
+            scheduledCallback.rescheduledDue = newDue;
+        } else if (newDue >= scheduledCallback.due) {
+            // Moving the callback later is only recorded, and the callback
+            // is moved once its old due time comes, so that pushing back
+            // a deadline over and over again is cheap.
+            scheduledCallback.rescheduledDue = (
+                (newDue == scheduledCallback.due)
+                ? NO_DUE
+                : newDue
+            );
+            return true;
+        } else {
+            shard->scheduledCallbacks->Remove(slot);
+            scheduledCallback.due = newDue;
+            scheduledCallback.rescheduledDue = NO_DUE;
+            shard->scheduledCallbacks->Add(slot);
+        }
+        lock.unlock();
+        impl_->WakeWorkerIfSooner(newDue);
+        return true;
+    }
+
+    bool Scheduler::Reschedule(
+        Token token,
+        double due
+    ) {
+        return Reschedule(
+            token,
+            std::chrono::nanoseconds(Clock::SecondsToTicks(due))
+        );
+    }
+
+    bool Scheduler::RescheduleAfter(
+        Token token,
+        std::chrono::nanoseconds delay
+    ) {
+        if (impl_->clock == nullptr) {
+            return false;
+        }
+        const auto now = impl_->clock->GetCurrentTicks();
+        return Reschedule(
+            token,
+            std::chrono::nanoseconds(
+                AddTicks(now, std::max((int64_t)0, (int64_t)delay.count()))
+            )
+        );
+    }
+
+    auto Scheduler::ScheduleMany(std::vector< ScheduleRequest > requests) -> std::vector< Token > {
+        if (handle_ != nullptr) {
+            std::lock_guard< decltype(handle_->mutex) > lock(handle_->mutex);
+            const auto tokens = handle_->engine.ScheduleMany(std::move(requests));
+            for (const auto token: tokens) {
+                handle_->Remember(token);
+            }
+            return tokens;
+        }
+        std::vector< Token > tokens(requests.size());
+        if (
+            (impl_->clock == nullptr)
+            || impl_->shutDown
+            || requests.empty()
+        ) {
+            return tokens;
+        }
+        std::vector< size_t > slots;
+        slots.reserve(requests.size());
+        auto earliestDue = INT64_MAX;
+        for (const auto& request: requests) {
+            earliestDue = std::min(
+                earliestDue,
+                ApplySlack(request.due.count(), request.slack.count())
+            );
+        }
+        auto& shard = impl_->GetCurrentThreadShard();
+        if (impl_->lockFreeSubmission) {
+            const UnlockedShardUse use(shard, impl_->shutDown);
+            if (!use.allowed) {
+                return tokens;
+            }
+            // Link all the slots together first, so that they're handed
+            // to the worker thread with a single push.
+            auto first = NO_SLOT;
+            auto last = NO_SLOT;
+            for (size_t i = 0; i < requests.size(); ++i) {
+                const auto slot = shard.PrepareSlot(std::move(requests[i]));
+                if (slot == NO_SLOT) {
+                    continue;
+                }
+                tokens[i] = shard.MakeToken(slot);
+                impl_->TraceScheduled(tokens[i], shard.slots[slot].due);
+                if (last == NO_SLOT) {
+                    last = slot;
+                } else {
+                    shard.slots[slot].nextSubmission = first;
+                }
+                first = slot;
+            }
+            if (first == NO_SLOT) {
+                return tokens;
+            }
+            shard.Submit(first, last);
+            impl_->WakeWorkerIfSooner(earliestDue);
+            return tokens;
+        }
+        std::unique_lock< decltype(shard.mutex) > lock(shard.mutex);
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const auto slot = shard.PrepareSlot(std::move(requests[i]));
+            if (slot == NO_SLOT) {
+                continue;
+            }
+            tokens[i] = shard.MakeToken(slot);
+            impl_->TraceScheduled(tokens[i], shard.slots[slot].due);
+            slots.push_back(slot);
+        }
+        shard.scheduledCallbacks->AddMany(slots);
+        lock.unlock();
+        impl_->WakeWorkerIfSooner(earliestDue);
+        return tokens;
+    }
+
+    void Scheduler::RegisterCallbackFactory(
+        uint32_t type,
+        CallbackFactory factory
+    ) {
+        std::lock_guard< decltype(impl_->callbackFactoriesMutex) > lock(impl_->callbackFactoriesMutex);
+        if (factory == nullptr) {
+            (void)impl_->callbackFactories.erase(type);
+        } else {
+            impl_->callbackFactories[type] = std::move(factory);
+        }
+    }
+
+    std::vector< uint8_t > Scheduler::Snapshot() const {
+        std::vector< uint8_t > snapshot;
+        PutBytes(snapshot, SNAPSHOT_MAGIC, 4);
+        PutBytes(snapshot, SNAPSHOT_VERSION, 4);
+        PutBytes(snapshot, 0, 8);
+        uint64_t records = 0;
+        if (handle_ != nullptr) {
+            // Only the callbacks scheduled through this scheduler are
+            // recorded, rather than all of those of the timer service.
+            std::lock_guard< decltype(handle_->mutex) > lock(handle_->mutex);
+            for (const auto token: handle_->tokens) {
+                const auto shard = impl_->GetTokenShard(token);
+                if (shard == nullptr) {
+                    continue;
+                }
+                std::lock_guard< decltype(shard->mutex) > shardLock(shard->mutex);
+                size_t slot;
+                if (
+                    shard->FindScheduled(token, slot)
+                    && (shard->slots[slot].type != 0)
+                ) {
+                    AppendSnapshotRecord(snapshot, shard->slots[slot]);
+                    ++records;
+                }
+            }
+        } else {
+            for (const auto& shard: impl_->shards) {
+                std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+                // Slots may be added without the lock in lock-free
+                // submission mode, in which case the table can count a
+                // slot before the chunk holding it is in place.
+                const auto size = shard->slots.GetSize();
+                for (size_t slot = 0; slot < size; ++slot) {
+                    const auto scheduledCallback = shard->slots.Find(slot);
+                    if (
+                        (scheduledCallback == nullptr)
+                        || (
+                            (scheduledCallback->status.load(std::memory_order_acquire) & (SLOT_ALLOCATED | SLOT_CANCELED))
+                            != SLOT_ALLOCATED
+                        )
+                    ) {
+                        continue;
+                    }
+                    if (scheduledCallback->type == 0) {
+                        continue;
+                    }
+                    AppendSnapshotRecord(snapshot, *scheduledCallback);
+                    ++records;
+                }
+            }
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            snapshot[8 + i] = (uint8_t)(records >> (8 * i));
+        }
+        return snapshot;
+    }
+
+    auto Scheduler::Restore(
+        const void* snapshot,
+        size_t size
+    ) -> std::vector< RestoredCallback > {
+        std::vector< RestoredCallback > restoredCallbacks;
+        const auto bytes = (const uint8_t*)snapshot;
+        if (
+            (bytes == nullptr)
+            || (size < SNAPSHOT_HEADER_SIZE)
+            || (GetBytes(bytes, 4) != SNAPSHOT_MAGIC)
+            || (GetBytes(bytes + 4, 4) != SNAPSHOT_VERSION)
+        ) {
+            return restoredCallbacks;
+        }
+        const auto records = GetBytes(bytes + 8, 8);
+        if (records > (size - SNAPSHOT_HEADER_SIZE) / SNAPSHOT_RECORD_SIZE) {
+            return restoredCallbacks;
+        }
+
+        // The factories are copied so that they're not called while
+        // holding the lock, in case they register factories themselves.
+        std::unique_lock< decltype(impl_->callbackFactoriesMutex) > lock(impl_->callbackFactoriesMutex);
+        const auto callbackFactories = impl_->callbackFactories;
+        lock.unlock();
+        std::vector< ScheduleRequest > requests;
+        requests.reserve((size_t)records);
+        restoredCallbacks.reserve((size_t)records);
+        for (size_t i = 0; i < (size_t)records; ++i) {
+            const auto record = bytes + SNAPSHOT_HEADER_SIZE + i * SNAPSHOT_RECORD_SIZE;
+            const auto type = (uint32_t)GetBytes(record, 4);
+            const auto periodicMode = GetBytes(record + 4, 1);
+            const auto catchUp = GetBytes(record + 5, 1);
+            if (
+                (periodicMode > (uint64_t)PeriodicMode::FixedDelay)
+                || (catchUp > (uint64_t)CatchUp::SkipMissedPeriods)
+            ) {
+                continue;
+            }
+            const auto callbackFactoriesEntry = callbackFactories.find(type);
+            if (callbackFactoriesEntry == callbackFactories.end()) {
+                continue;
+            }
+            const auto key = GetBytes(record + 8, 8);
+            auto callback = callbackFactoriesEntry->second(key);
+            if (!callback) {
+                continue;
+            }
+            ScheduleRequest request;
+            request.callback = std::move(callback);
+            request.due = std::chrono::nanoseconds((int64_t)GetBytes(record + 16, 8));
+            request.slack = std::chrono::nanoseconds((int64_t)GetBytes(record + 24, 8));
+            request.interval = std::chrono::nanoseconds((int64_t)GetBytes(record + 32, 8));
+            request.strand = GetBytes(record + 40, 8);
+            request.periodicMode = (PeriodicMode)periodicMode;
+            request.catchUp = (CatchUp)catchUp;
+            request.type = type;
+            request.key = key;
+            requests.push_back(std::move(request));
+            RestoredCallback restoredCallback;
+            restoredCallback.key = key;
+            restoredCallbacks.push_back(restoredCallback);
+        }
+        const auto tokens = ScheduleMany(std::move(requests));
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            restoredCallbacks[i].token = tokens[i];
+        }
+        return restoredCallbacks;
+    }
+
+    void Scheduler::CancelMany(const std::vector< Token >& tokens) {
+        if (handle_ != nullptr) {
+            std::vector< Token > releasedTokens;
+            std::unique_lock< decltype(handle_->mutex) > lock(handle_->mutex);
+            for (const auto token: tokens) {
+                if (handle_->Release(token)) {
+                    releasedTokens.push_back(token);
+                }
+            }
+            lock.unlock();
+            handle_->engine.CancelMany(releasedTokens);
+            return;
+        }
+        // The canceled callbacks are moved here so that they're destroyed
+        // only after the lock is released, in case destroying them
+        // causes the scheduler to be used again.
+        std::vector< Callback > callbacks;
+        callbacks.reserve(tokens.size());
+        Shard* lockedShard = nullptr;
+        std::unique_lock< decltype(lockedShard->mutex) > lock;
+        if (impl_->lockFreeSubmission) {
+            auto canceledAny = false;
+            for (const auto token: tokens) {
+                const auto shard = impl_->GetTokenShard(token);
+                if (shard == nullptr) {
+                    continue;
+                }
+                const UnlockedShardUse use(*shard, impl_->shutDown);
+                size_t slot;
+                if (
+                    use.allowed
+                    && shard->MarkCanceled(token, slot)
+                ) {
+                    impl_->TraceCanceled(token);
+                    callbacks.push_back(shard->TakeCanceledCallback(slot));
+                    shard->SubmitCancellation(slot);
+                    canceledAny = true;
+                }
+            }
+            if (canceledAny) {
+                impl_->WakeWorker();
+            }
+            return;
+        }
+        for (const auto token: tokens) {
+            const auto shard = impl_->GetTokenShard(token);
+            if (shard == nullptr) {
+                continue;
+            }
+            if (shard != lockedShard) {
+                if (lock.owns_lock()) {
+                    lock.unlock();
+                }
+                lock = std::unique_lock< decltype(shard->mutex) >(shard->mutex);
+                lockedShard = shard;
+            }
+            size_t slot;
+            if (!shard->MarkCanceled(token, slot)) {
+                continue;
+            }
+            impl_->TraceCanceled(token);
+            callbacks.push_back(shard->RemoveCanceledSlot(slot));
+        }
+    }
+
+    void Scheduler::Reserve(size_t callbacks) {
+        for (auto& shard: impl_->shards) {
+            std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+            shard->Reserve(callbacks);
+        }
+    }
+
+    void Scheduler::ShrinkToFit() {
+        for (auto& shard: impl_->shards) {
+            std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+            if (impl_->lockFreeSubmission) {
+                shard->scheduledCallbacks->ShrinkToFit();
+            } else {
+                shard->ShrinkToFit();
+            }
+        }
+    }
+
+    size_t Scheduler::Shutdown(
+        ShutdownPolicy policy,
+        std::chrono::nanoseconds drainTime
+    ) {
+        if (handle_ != nullptr) {
+            std::unique_lock< decltype(handle_->mutex) > lock(handle_->mutex);
+            handle_->Prune();
+            const auto tracked = handle_->tokens.size();
+            lock.unlock();
+            CancelTrackedCallbacks();
+            return tracked;
+        }
+        impl_->shutDown = true;
+        impl_->StopThreads();
+        if (policy != ShutdownPolicy::DropAll) {
+            impl_->CallRemainingCallbacks(
+                (policy == ShutdownPolicy::Drain),
+                drainTime
+            );
+        }
+        return impl_->DropCallbacks();
+    }
+
+    auto Scheduler::GetStatistics() const -> Statistics {
+        Statistics statistics;
+        statistics.wakeUps = impl_->wakeUps.load(std::memory_order_relaxed);
+        statistics.usefulWakeUps = impl_->usefulWakeUps.load(std::memory_order_relaxed);
+        for (const auto& shard: impl_->shards) {
+            statistics.pending += shard->pending.load(std::memory_order_relaxed);
+            statistics.canceledUnreclaimed += shard->canceledUnreclaimed.load(
+                std::memory_order_relaxed
+            );
+        }
+        statistics.fired = impl_->fired.load(std::memory_order_relaxed);
+        statistics.medianLateness = std::chrono::nanoseconds(
+            impl_->lateness.GetPercentile(0.5)
+        );
+        statistics.lateness99th = std::chrono::nanoseconds(
+            impl_->lateness.GetPercentile(0.99)
+        );
+        statistics.maxLateness = std::chrono::nanoseconds(
+            impl_->lateness.maximum.load(std::memory_order_relaxed)
+        );
+        statistics.medianCallbackTime = std::chrono::nanoseconds(
+            impl_->callbackTime.GetPercentile(0.5)
+        );
+        statistics.callbackTime99th = std::chrono::nanoseconds(
+            impl_->callbackTime.GetPercentile(0.99)
+        );
+        statistics.maxCallbackTime = std::chrono::nanoseconds(
+            impl_->callbackTime.maximum.load(std::memory_order_relaxed)
+        );
+        return statistics;
+    }
+
+    std::chrono::nanoseconds Scheduler::GetNextDeadline() {
+        // As with the worker thread, the deadline is treated as infinite
+        // while it's being worked out, so that callbacks scheduled in the
+        // meantime always tell the owner to look again.
+        if (impl_->pollDescriptor != nullptr) {
+            impl_->pollDescriptor->Clear();
+        }
+        (void)impl_->wakeRequested.exchange(false);
+        impl_->sleepingUntil = INT64_MAX;
+        auto nextDeadline = INT64_MAX;
+        std::vector< Callback > released;
+        for (auto& shard: impl_->shards) {
+            std::lock_guard< decltype(shard->mutex) > lock(shard->mutex);
+            if (impl_->lockFreeSubmission) {
+                shard->TakeSubmissions(impl_->threadlessSubmitted, released);
+                shard->TakeCancellations(released);
+            }
+            if (!shard->scheduledCallbacks->IsEmpty()) {
+                nextDeadline = std::min(
+                    nextDeadline,
+                    shard->scheduledCallbacks->GetNextDue()
+                );
+            }
+        }
+        impl_->sleepingUntil = nextDeadline;
+        if (impl_->pollDescriptor != nullptr) {
+            // The timer is armed for at most the longest wait of the
+            // worker thread, after which the owner looks again.
+            const auto clock = impl_->clock;
+            if (
+                (clock == nullptr)
+                || (nextDeadline == INT64_MAX)
+            ) {
+                impl_->pollDescriptor->Arm(INT64_MAX);
+            } else {
+                const auto now = clock->GetCurrentTicks();
+                impl_->pollDescriptor->Arm(
+                    (nextDeadline <= now)
+                    ? 0
+                    : (int64_t)std::min(
+                        (uint64_t)MAX_WAIT,
+                        (uint64_t)nextDeadline - (uint64_t)now
+                    )
+                );
+            }
+        }
+        return std::chrono::nanoseconds(nextDeadline);
+    }
+
+    int Scheduler::GetPollDescriptor() const {
+        if (impl_->pollDescriptor == nullptr) {
+            return -1;
+        }
+        return impl_->pollDescriptor->Get();
+    }
+
+    size_t Scheduler::RunDue(std::chrono::nanoseconds now) {
+        auto sampledClock = true;
+        auto nowTicks = (int64_t)now.count();
+        std::chrono::steady_clock::time_point sampled;
+        int64_t nextDue;
+        (void)impl_->TakeDueCallbacks(
+            impl_->threadlessBatch,
+            impl_->threadlessSubmitted,
+            sampledClock,
+            nowTicks,
+            sampled,
+            nextDue
+        );
+        const auto called = impl_->threadlessBatch.size();
+        (void)impl_->wakeUps.fetch_add(1, std::memory_order_relaxed);
+        if (called > 0) {
+            (void)impl_->usefulWakeUps.fetch_add(1, std::memory_order_relaxed);
+            impl_->CallDueCallbacks(impl_->threadlessBatch, nowTicks);
+        }
+        return called;
+    }
+
+    size_t Scheduler::RunDue() {
+        const auto clock = impl_->clock;
+        if (clock == nullptr) {
+            return 0;
         }
+        return RunDue(std::chrono::nanoseconds(clock->GetCurrentTicks()));
     }
 
     void Scheduler::WakeUp() {
-        std::lock_guard< decltype(impl_->mutex) > lock(impl_->mutex);
-        impl_->wakeWorker.notify_one();
+        impl_->WakeWorker();
     }
 
 }
@@ -0,0 +1,111 @@
+/**
+ * @file SlotTable.cpp
+ *
+ * This module contains the implementation of the Timekeeping::SlotTable
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "SlotTable.hpp"
+
+namespace {
+
+    /**
+     * This is the largest number of slots a table may have.  It's limited
+     * so that every slot index fits in the bits of a token which hold it,
+     * with room left over for the encoding used by the list of free slots.
+     */
+    constexpr size_t MAX_SLOTS = (size_t)UINT32_MAX;
+
+}
+
+namespace Timekeeping {
+
+    constexpr unsigned int SlotTable::FIRST_CHUNK_BITS;
+    constexpr size_t SlotTable::FIRST_CHUNK_SIZE;
+    constexpr size_t SlotTable::CHUNKS;
+
+    SlotTable::~SlotTable() noexcept {
+        for (auto& chunk: chunks_) {
+            delete[] chunk.load();
+        }
+    }
+
+    SlotTable::SlotTable() {
+        for (auto& chunk: chunks_) {
+            chunk = nullptr;
+        }
+    }
+
+    ScheduledCallback* SlotTable::Find(size_t index) {
+        if (index >= MAX_SLOTS) {
+            return nullptr;
+        }
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        const auto slots = chunks_[chunk].load(std::memory_order_acquire);
+        if (slots == nullptr) {
+            return nullptr;
+        }
+        return &slots[offset];
+    }
+
+    size_t SlotTable::Add() {
+        const auto index = size_++;
+        if (index >= MAX_SLOTS) {
+            --size_;
+            return NO_SLOT;
+        }
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        if (chunks_[chunk].load(std::memory_order_acquire) == nullptr) {
+            // Another thread may be adding the same chunk at the same
+            // time, in which case only one of the new chunks is kept.
+            const auto chunkSize = FIRST_CHUNK_SIZE << chunk;
+            const auto newSlots = new ScheduledCallback[chunkSize];
+            for (size_t i = 0; i < chunkSize; ++i) {
+                newSlots[i].status.store(newSlotStatus_, std::memory_order_relaxed);
+            }
+            ScheduledCallback* noSlots = nullptr;
+            if (
+                !chunks_[chunk].compare_exchange_strong(
+                    noSlots,
+                    newSlots,
+                    std::memory_order_acq_rel
+                )
+            ) {
+                delete[] newSlots;
+            }
+        }
+        return index;
+    }
+
+    size_t SlotTable::GetSize() const {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    size_t SlotTable::GetChunkStart(size_t index) {
+        size_t chunk, offset;
+        Locate(index, chunk, offset);
+        if (offset == 0) {
+            return index;
+        }
+        return (FIRST_CHUNK_SIZE << (chunk + 1)) - FIRST_CHUNK_SIZE;
+    }
+
+    void SlotTable::Truncate(size_t size, uint32_t status) {
+        ScheduledCallback* released[CHUNKS] = {nullptr};
+        for (auto index = size; index < size_; index = GetChunkStart(index + 1)) {
+            size_t chunk, offset;
+            Locate(index, chunk, offset);
+            released[chunk] = chunks_[chunk].exchange(nullptr);
+        }
+        size_ = size;
+        newSlotStatus_ = status;
+        for (auto chunk: released) {
+            delete[] chunk;
+        }
+    }
+
+}
@@ -0,0 +1,390 @@
+#pragma once
+
+/**
+ * @file SlotTable.hpp
+ *
+ * This module declares the Timekeeping::SlotTable class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <Timekeeping/Scheduler.hpp>
+
+namespace Timekeeping {
+
+    /**
+     * This is used in place of a slot index to indicate "no slot".
+     */
+    constexpr size_t NO_SLOT = SIZE_MAX;
+
+    /**
+     * This is used in place of a due time to indicate "no due time".
+     */
+    constexpr int64_t NO_DUE = INT64_MIN;
+
+    /**
+     * This bit of the status of a slot is set while the slot holds
+     * a scheduled callback.
+     */
+    constexpr uint32_t SLOT_ALLOCATED = 2;
+
+    /**
+     * This bit of the status of a slot is set once the scheduled callback
+     * it holds has been canceled, until the slot is freed.
+     */
+    constexpr uint32_t SLOT_CANCELED = 1;
+
+    /**
+     * This is the number of bits by which the generation of a slot is
+     * shifted up within the status of the slot.
+     */
+    constexpr unsigned int SLOT_GENERATION_SHIFT = 2;
+
+    /**
+     * This holds everything the scheduler knows about one callback
+     * which has been scheduled to be called later.  These are kept in
+     * slots of a table shared by the scheduler and its timer queue,
+     * and are referred to by slot index.
+     */
+    struct ScheduledCallback {
+        // Properties
+
+        /**
+         * This combines the generation of the slot, which is incremented
+         * every time the slot is freed, so that tokens issued for earlier
+         * uses of the slot no longer match it, with the SLOT_ALLOCATED and
+         * SLOT_CANCELED bits.  The generation is never zero, so that zero
+         * is never a valid token.
+         *
+         * It's atomic so that the worker thread and threads canceling
+         * the callback can agree on which of them gets to finish with
+         * the callback, without sharing a lock.
+         */
+        std::atomic< uint32_t > status{1 << SLOT_GENERATION_SHIFT};
+
+        /**
+         * This is the time, in ticks of the scheduler's clock, at which
+         * the callback should be called, once any slack is applied.
+         */
+        int64_t due = 0;
+
+        /**
+         * This is the time, in ticks of the scheduler's clock, at which
+         * the callback was asked to be called, before any slack was
+         * applied.
+         */
+        int64_t requestedDue = 0;
+
+        /**
+         * This is how many ticks later than the requested due time the
+         * callback may be called.
+         */
+        int64_t slack = 0;
+
+        /**
+         * If not NO_DUE, the callback has been rescheduled to this time,
+         * but is still in the timer queue at its old due time, or isn't
+         * in the timer queue at the moment.  The new due time takes effect
+         * when the callback is next taken from, or put into, the queue.
+         */
+        int64_t rescheduledDue = NO_DUE;
+
+        /**
+         * This is the function to call when the callback is due.
+         */
+        Scheduler::Callback callback;
+
+        /**
+         * This is the key of the strand on which the callback should be
+         * called, or zero if it may be called in parallel with any others.
+         */
+        uint64_t strand = 0;
+
+        /**
+         * If nonzero, the callback is periodic, and this is the number
+         * of clock ticks between calls.
+         */
+        int64_t interval = 0;
+
+        /**
+         * This selects how the due time of each call of a periodic
+         * callback is chosen.
+         */
+        Scheduler::PeriodicMode periodicMode = Scheduler::PeriodicMode::FixedRate;
+
+        /**
+         * This selects how a fixed-rate periodic callback makes up for
+         * missed periods.
+         */
+        Scheduler::CatchUp catchUp = Scheduler::CatchUp::SkipMissedPeriods;
+
+        /**
+         * This names the place in the program which scheduled the
+         * callback, if it was given.
+         */
+        const char* site = nullptr;
+
+        /**
+         * This is the type of callback, used to restore it from a
+         * snapshot, or zero if it's left out of snapshots.
+         */
+        uint32_t type = 0;
+
+        /**
+         * This is kept along with the callback in snapshots.
+         */
+        uint64_t key = 0;
+
+        /**
+         * This is used by the timer queue to locate the scheduled
+         * callback within its own data structure, so that it can be
+         * removed without searching for it.
+         */
+        size_t queuePosition = NO_SLOT;
+
+        /**
+         * This is the index of the next slot in whatever timer queue list
+         * this slot is in, if any.
+         */
+        size_t next = NO_SLOT;
+
+        /**
+         * This is the index of the previous slot in whatever timer queue
+         * list this slot is in, if any.
+         */
+        size_t previous = NO_SLOT;
+
+        /**
+         * While the slot is free, this is one more than the index of the
+         * next free slot, or zero if this is the last free slot.
+         */
+        std::atomic< uint32_t > nextFree{0};
+
+        /**
+         * This is the index of the next slot in the list of slots waiting
+         * for the worker thread to add them to the timer queue, if any.
+         */
+        size_t nextSubmission = NO_SLOT;
+
+        /**
+         * This is the index of the next slot in the list of slots waiting
+         * for the worker thread to remove them from the timer queue,
+         * if any.
+         */
+        size_t nextCancellation = NO_SLOT;
+
+        /**
+         * This is set once the worker thread has taken the slot from the
+         * list of slots waiting to be added to the timer queue.
+         */
+        bool submitted = false;
+
+        /**
+         * This is set if the worker thread takes the slot from the list of
+         * slots waiting to be removed from the timer queue before it takes
+         * the slot from the list of slots waiting to be added to it.
+         */
+        bool cancellationReceived = false;
+    };
+
+    /**
+     * This is a table of slots holding scheduled callbacks, which grows
+     * as needed but never moves the slots it already has, so that slots
+     * can be added by one thread while other threads use existing slots.
+     *
+     * The table is made up of chunks which double in size, so the slot
+     * at a given index is found with a little arithmetic and one load
+     * of the pointer to the chunk holding it.
+     */
+    class SlotTable {
+        // Lifecycle Methods
+    public:
+        ~SlotTable() noexcept;
+        SlotTable(const SlotTable&) = delete;
+        SlotTable(SlotTable&&) = delete;
+        SlotTable& operator=(const SlotTable&) = delete;
+        SlotTable& operator=(SlotTable&&) = delete;
+
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         */
+        SlotTable();
+
+        /**
+         * Return the slot at the given index, which must have been
+         * returned by the Add method.
+         *
+         * @note
+         *     This is defined here so that it can be inlined into the
+         *     inner loops of the timer queues.
+         *
+         * @param[in] index
+         *     This is the index of the slot to return.
+         *
+         * @return
+         *     The slot at the given index is returned.
+         */
+        ScheduledCallback& operator[](size_t index) {
+            size_t chunk, offset;
+            Locate(index, chunk, offset);
+            return chunks_[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        /**
+         * Return the slot at the given index, which must have been
+         * returned by the Add method.
+         *
+         * @param[in] index
+         *     This is the index of the slot to return.
+         *
+         * @return
+         *     The slot at the given index is returned.
+         */
+        const ScheduledCallback& operator[](size_t index) const {
+            size_t chunk, offset;
+            Locate(index, chunk, offset);
+            return chunks_[chunk].load(std::memory_order_acquire)[offset];
+        }
+
+        /**
+         * Return the slot at the given index, if the table has a slot
+         * there.
+         *
+         * @param[in] index
+         *     This is the index of the slot to return.
+         *
+         * @return
+         *     The slot at the given index is returned, or null if the
+         *     table has no slot there.
+         */
+        ScheduledCallback* Find(size_t index);
+
+        /**
+         * Add a new slot to the table.  This may be called by more than
+         * one thread at a time.
+         *
+         * @return
+         *     The index of the new slot is returned, or NO_SLOT if the
+         *     table is full.
+         */
+        size_t Add();
+
+        /**
+         * Return the number of slots which have been added to the table.
+         *
+         * @return
+         *     The number of slots which have been added to the table
+         *     is returned.
+         */
+        size_t GetSize() const;
+
+        /**
+         * Return the smallest index, no less than the given one, at
+         * which a chunk of the table starts.
+         *
+         * @param[in] index
+         *     This is the index from which to look for the start of
+         *     a chunk.
+         *
+         * @return
+         *     The index of the first slot of the first chunk starting at
+         *     or after the given index is returned.
+         */
+        static size_t GetChunkStart(size_t index);
+
+        /**
+         * Release every chunk of the table from the given index on, so
+         * that the table only has slots before that index.  This must not
+         * be called while any other thread uses the table.
+         *
+         * The chunks are all taken out of the table before any of them is
+         * released, so that if destroying the callbacks they hold uses
+         * the table again, the released slots are already gone.
+         *
+         * @param[in] size
+         *     This is the number of slots to keep.  It must be the start
+         *     of a chunk, as returned by GetChunkStart.
+         *
+         * @param[in] status
+         *     This is the status to give the slots of any chunks added
+         *     to the table again afterwards, so that tokens issued for
+         *     the slots being released don't match the slots which later
+         *     take their place.
+         */
+        void Truncate(size_t size, uint32_t status);
+
+        // Private Methods
+    private:
+        /**
+         * Find where in the table the slot with the given index is.
+         *
+         * @param[in] index
+         *     This is the index of the slot to find.
+         *
+         * @param[out] chunk
+         *     This is where to store the index of the chunk holding
+         *     the slot.
+         *
+         * @param[out] offset
+         *     This is where to store the position of the slot within
+         *     its chunk.
+         */
+        static void Locate(size_t index, size_t& chunk, size_t& offset) {
+            const auto position = (uint64_t)index + FIRST_CHUNK_SIZE;
+            unsigned int highestBit;
+#if defined(__GNUC__) || defined(__clang__)
+            highestBit = 63 - (unsigned int)__builtin_clzll(position);
+#else
+            highestBit = 0;
+            while ((position >> highestBit) > 1) {
+                ++highestBit;
+            }
+#endif
+            chunk = highestBit - FIRST_CHUNK_BITS;
+            offset = (size_t)(position - ((uint64_t)1 << highestBit));
+        }
+
+        // Private properties
+    private:
+        /**
+         * This is the number of bits needed to hold the position of a slot
+         * within the first chunk of the table.
+         */
+        static constexpr unsigned int FIRST_CHUNK_BITS = 6;
+
+        /**
+         * This is the number of slots in the first chunk of the table.
+         * Each chunk after it is twice as big as the one before.
+         */
+        static constexpr size_t FIRST_CHUNK_SIZE = (size_t)1 << FIRST_CHUNK_BITS;
+
+        /**
+         * This is the number of chunks the table can have, which is
+         * enough to hold slots at every index a token can represent.
+         */
+        static constexpr size_t CHUNKS = 27;
+
+        /**
+         * These point to the chunks of slots of the table, or are null
+         * for chunks which haven't been needed yet.
+         */
+        std::atomic< ScheduledCallback* > chunks_[CHUNKS];
+
+        /**
+         * This is the number of slots which have been added to the table.
+         */
+        std::atomic< size_t > size_{0};
+
+        /**
+         * This is the status given to the slots of each chunk as it's
+         * added to the table.
+         */
+        uint32_t newSlotStatus_ = 1 << SLOT_GENERATION_SHIFT;
+    };
+
+}
@@ -0,0 +1,21 @@
+/**
+ * @file SteadyClock.cpp
+ *
+ * This module contains the implementation of the Timekeeping::SteadyClock
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <Timekeeping/SteadyClock.hpp>
+
+namespace Timekeeping {
+
+    int64_t SteadyClock::GetCurrentTicks() {
+        return (int64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+}
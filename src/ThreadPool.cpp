@@ -0,0 +1,223 @@
+/**
+ * @file ThreadPool.cpp
+ *
+ * This module contains the implementation of the Timekeeping::ThreadPool
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <Timekeeping/ThreadPool.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    /**
+     * This holds the tasks waiting to be run by one thread of a pool.
+     * The thread takes tasks from the front, while other threads steal
+     * tasks from the back.
+     */
+    struct TaskQueue {
+        // Properties
+
+        std::mutex mutex;
+        std::deque< Timekeeping::ThreadPool::Task > tasks;
+    };
+
+}
+
+namespace Timekeeping {
+
+    /**
+     * This contains the private properties of a ThreadPool class instance.
+     */
+    struct ThreadPool::Impl {
+        // Properties
+
+        /**
+         * This points to the pool whose thread is the current thread,
+         * if any.
+         */
+        static thread_local Impl* currentPool;
+
+        /**
+         * This is the index of the queue of the current thread, if the
+         * current thread belongs to a pool.
+         */
+        static thread_local size_t currentQueue;
+
+        std::vector< std::unique_ptr< TaskQueue > > queues;
+        std::vector< std::thread > threads;
+        std::atomic< size_t > nextQueue{0};
+        std::atomic< size_t > pending{0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeThreads;
+        bool stop = false;
+        std::mutex strandsMutex;
+        std::unordered_map< uint64_t, std::deque< Task > > strands;
+
+        // Lifecycle
+
+        ~Impl() noexcept {
+            std::unique_lock< decltype(sleepMutex) > lock(sleepMutex);
+            stop = true;
+            wakeThreads.notify_all();
+            lock.unlock();
+            for (auto& thread: threads) {
+                thread.join();
+            }
+        }
+        Impl(const Impl&) noexcept = delete;
+        Impl(Impl&&) = delete;
+        Impl& operator=(const Impl&) = delete;
+        Impl& operator=(Impl&&) = delete;
+
+        // Methods
+
+        explicit Impl(size_t numThreads) {
+            numThreads = std::max((size_t)1, numThreads);
+            for (size_t i = 0; i < numThreads; ++i) {
+                queues.emplace_back(new TaskQueue());
+            }
+            for (size_t i = 0; i < numThreads; ++i) {
+                threads.emplace_back(&Impl::Worker, this, i);
+            }
+        }
+
+        void Enqueue(Task&& task) {
+            // Tasks posted by one of the pool's own threads go to the
+            // back of that thread's queue, to keep related work together.
+            // Others are spread across the threads.
+            const auto queueIndex = (
+                (currentPool == this)
+                ? currentQueue
+                : (nextQueue++ % queues.size())
+            );
+            // The task is counted before it's queued, so that a thread
+            // which steals it right away never counts it off first.
+            std::unique_lock< decltype(sleepMutex) > sleepLock(sleepMutex);
+            ++pending;
+            sleepLock.unlock();
+            auto& queue = *queues[queueIndex];
+            std::unique_lock< decltype(queue.mutex) > queueLock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+            queueLock.unlock();
+            wakeThreads.notify_one();
+        }
+
+        void EnqueueOnStrand(Task&& task, uint64_t strand) {
+            std::lock_guard< decltype(strandsMutex) > lock(strandsMutex);
+            auto strandsEntry = strands.find(strand);
+            if (strandsEntry == strands.end()) {
+                strands[strand].push_back(std::move(task));
+                Enqueue([this, strand]{ RunStrand(strand); });
+            } else {
+                strandsEntry->second.push_back(std::move(task));
+            }
+        }
+
+        void RunStrand(uint64_t strand) {
+            // The entry for the strand stays in the table for as long as
+            // one of its tasks is queued or running, which is how tasks
+            // posted to the strand know not to start another runner.
+            Task task;
+            std::unique_lock< decltype(strandsMutex) > lock(strandsMutex);
+            auto& tasks = strands[strand];
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            lock.unlock();
+            task();
+            task = nullptr;
+            lock.lock();
+            auto strandsEntry = strands.find(strand);
+            if (strandsEntry->second.empty()) {
+                (void)strands.erase(strandsEntry);
+            } else {
+                lock.unlock();
+                Enqueue([this, strand]{ RunStrand(strand); });
+            }
+        }
+
+        bool TakeTask(size_t self, Task& task) {
+            {
+                auto& queue = *queues[self];
+                std::lock_guard< decltype(queue.mutex) > lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); ++i) {
+                auto& queue = *queues[(self + i) % queues.size()];
+                std::lock_guard< decltype(queue.mutex) > lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void Worker(size_t self) {
+            currentPool = this;
+            currentQueue = self;
+            for (;;) {
+                Task task;
+                if (TakeTask(self, task)) {
+                    --pending;
+                    task();
+                    continue;
+                }
+                std::unique_lock< decltype(sleepMutex) > lock(sleepMutex);
+                wakeThreads.wait(
+                    lock,
+                    [this]{ return stop || (pending > 0); }
+                );
+                if (stop && (pending == 0)) {
+                    break;
+                }
+            }
+            currentPool = nullptr;
+        }
+    };
+
+    thread_local ThreadPool::Impl* ThreadPool::Impl::currentPool = nullptr;
+    thread_local size_t ThreadPool::Impl::currentQueue = 0;
+
+    ThreadPool::~ThreadPool() noexcept = default;
+    ThreadPool::ThreadPool(ThreadPool&&) noexcept = default;
+    ThreadPool& ThreadPool::operator=(ThreadPool&&) noexcept = default;
+
+    ThreadPool::ThreadPool(size_t threads)
+        : impl_(new Impl(threads))
+    {
+    }
+
+    void ThreadPool::Post(
+        Task task,
+        uint64_t strand
+    ) {
+        if (strand == 0) {
+            impl_->Enqueue(std::move(task));
+        } else {
+            impl_->EnqueueOnStrand(std::move(task), strand);
+        }
+    }
+
+    void ThreadPool::Execute(
+        Task task,
+        uint64_t strand
+    ) {
+        Post(std::move(task), strand);
+    }
+
+}
@@ -0,0 +1,18 @@
+/**
+ * @file TickClock.cpp
+ *
+ * This module contains the implementation of the Timekeeping::TickClock
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Timekeeping/TickClock.hpp>
+
+namespace Timekeeping {
+
+    double TickClock::GetCurrentTime() {
+        return TicksToSeconds(GetCurrentTicks());
+    }
+
+}
@@ -0,0 +1,192 @@
+/**
+ * @file TimerHeap.cpp
+ *
+ * This module contains the implementation of the Timekeeping::TimerHeap
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TimerHeap.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+    /**
+     * This is the number of children of each element of the heap.
+     */
+    constexpr size_t ARITY = 4;
+
+    /**
+     * This is used to select the bits of the order of a node which hold
+     * the index of the slot of the scheduled callback.
+     */
+    constexpr uint64_t ORDER_SLOT_MASK = ((uint64_t)1 << 32) - 1;
+
+}
+
+namespace Timekeeping {
+
+    TimerHeap::TimerHeap(
+        SlotTable& slots,
+        uint32_t firstSequence
+    )
+        : slots_(slots)
+        , nextSequence_(firstSequence)
+    {
+    }
+
+    void TimerHeap::Add(size_t slot) {
+        heap_.push_back(MakeNode(slot));
+        SiftUp(heap_.size() - 1);
+    }
+
+    void TimerHeap::AddMany(const std::vector< size_t >& slots) {
+        // Pushing each new element onto the heap costs up to logarithmic
+        // time per element, while rebuilding the whole heap from scratch
+        // costs linear time in the size of the heap, so rebuild only
+        // when the heap is at least doubling in size.
+        if (slots.size() < heap_.size()) {
+            TimerQueue::AddMany(slots);
+            return;
+        }
+        heap_.reserve(heap_.size() + slots.size());
+        for (const auto slot: slots) {
+            const auto node = MakeNode(slot);
+            slots_[slot].queuePosition = heap_.size();
+            heap_.push_back(node);
+        }
+        for (auto position = (heap_.size() + ARITY - 2) / ARITY; position > 0; --position) {
+            SiftDown(position - 1);
+        }
+    }
+
+    void TimerHeap::Reserve(size_t count) {
+        heap_.reserve(count);
+    }
+
+    void TimerHeap::ShrinkToFit() {
+        heap_.shrink_to_fit();
+    }
+
+    void TimerHeap::Clear() {
+        std::vector< Node >().swap(heap_);
+    }
+
+    void TimerHeap::Remove(size_t slot) {
+        const auto position = slots_[slot].queuePosition;
+        slots_[slot].queuePosition = NO_SLOT;
+        const auto last = heap_.back();
+        heap_.pop_back();
+        if (position == heap_.size()) {
+            return;
+        }
+        heap_[position] = last;
+        if (
+            (position > 0)
+            && Precedes(heap_[position], heap_[(position - 1) / ARITY])
+        ) {
+            SiftUp(position);
+        } else {
+            SiftDown(position);
+        }
+    }
+
+    bool TimerHeap::IsEmpty() const {
+        return heap_.empty();
+    }
+
+    int64_t TimerHeap::GetNextDue() const {
+        return heap_.front().due;
+    }
+
+    bool TimerHeap::PopDue(
+        int64_t now,
+        size_t& slot
+    ) {
+        if (
+            heap_.empty()
+            || (heap_.front().due > now)
+        ) {
+            return false;
+        }
+        slot = (size_t)(heap_.front().order & ORDER_SLOT_MASK);
+        Remove(slot);
+        return true;
+    }
+
+    auto TimerHeap::MakeNode(size_t slot) -> Node {
+        if (nextSequence_ == UINT32_MAX) {
+            Renumber();
+        }
+        Node node;
+        node.due = slots_[slot].due;
+        node.order = ((uint64_t)nextSequence_++ << 32) | (uint64_t)slot;
+        return node;
+    }
+
+    void TimerHeap::Renumber() {
+        // Nodes keep their places in the heap, since renumbering them
+        // doesn't change how they're ordered relative to each other.
+        std::vector< size_t > positions(heap_.size());
+        std::iota(positions.begin(), positions.end(), (size_t)0);
+        std::sort(
+            positions.begin(),
+            positions.end(),
+            [this](size_t lhs, size_t rhs){
+                return Precedes(heap_[lhs], heap_[rhs]);
+            }
+        );
+        uint64_t sequence = 0;
+        for (const auto position: positions) {
+            auto& order = heap_[position].order;
+            order = (sequence++ << 32) | (order & ORDER_SLOT_MASK);
+        }
+        nextSequence_ = (uint32_t)sequence;
+    }
+
+    void TimerHeap::Place(size_t position, const Node& node) {
+        heap_[position] = node;
+        slots_[(size_t)(node.order & ORDER_SLOT_MASK)].queuePosition = position;
+    }
+
+    void TimerHeap::SiftUp(size_t position) {
+        const auto node = heap_[position];
+        while (position > 0) {
+            const auto parent = (position - 1) / ARITY;
+            if (!Precedes(node, heap_[parent])) {
+                break;
+            }
+            Place(position, heap_[parent]);
+            position = parent;
+        }
+        Place(position, node);
+    }
+
+    void TimerHeap::SiftDown(size_t position) {
+        const auto node = heap_[position];
+        const auto size = heap_.size();
+        for (;;) {
+            const auto firstChild = position * ARITY + 1;
+            if (firstChild >= size) {
+                break;
+            }
+            auto child = firstChild;
+            const auto lastChild = std::min(size, firstChild + ARITY);
+            for (auto sibling = firstChild + 1; sibling < lastChild; ++sibling) {
+                if (Precedes(heap_[sibling], heap_[child])) {
+                    child = sibling;
+                }
+            }
+            if (!Precedes(heap_[child], node)) {
+                break;
+            }
+            Place(position, heap_[child]);
+            position = child;
+        }
+        Place(position, node);
+    }
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+/**
+ * @file TimerHeap.hpp
+ *
+ * This module declares the Timekeeping::TimerHeap class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TimerQueue.hpp"
+
+#include <vector>
+
+namespace Timekeeping {
+
+    /**
+     * This is a timer queue which keeps scheduled callbacks in a 4-ary
+     * min-heap ordered by due time, so that callbacks are always called
+     * in the exact order of their due times, and callbacks due at the
+     * same time are called in the order they were added.  Each scheduled
+     * callback records its own position in the heap, so that it can be
+     * removed from anywhere in the heap in logarithmic time.
+     *
+     * The heap holds only the due time, order of addition, and slot index
+     * of each scheduled callback, so that moving elements around and
+     * comparing them never touches the slots themselves.
+     */
+    class TimerHeap
+        : public TimerQueue
+    {
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         *
+         * @param[in] slots
+         *     This is the table of slots holding the scheduled callbacks
+         *     which the heap orders.
+         *
+         * @param[in] firstSequence
+         *     This is the number used to order the first scheduled
+         *     callback added to the heap among others due at the same
+         *     time.  It's only meant to be given by tests, to check what
+         *     happens when the numbers run out.
+         */
+        explicit TimerHeap(
+            SlotTable& slots,
+            uint32_t firstSequence = 0
+        );
+
+        // TimerQueue
+
+        virtual void Add(size_t slot) override;
+        virtual void AddMany(const std::vector< size_t >& slots) override;
+        virtual void Reserve(size_t count) override;
+        virtual void ShrinkToFit() override;
+        virtual void Clear() override;
+        virtual void Remove(size_t slot) override;
+        virtual bool IsEmpty() const override;
+        virtual int64_t GetNextDue() const override;
+        virtual bool PopDue(
+            int64_t now,
+            size_t& slot
+        ) override;
+
+        // Private Types
+    private:
+        /**
+         * This is one element of the heap.
+         */
+        struct Node {
+            /**
+             * This is a copy of the due time of the scheduled callback,
+             * which doesn't change while the callback is in the heap.
+             */
+            int64_t due;
+
+            /**
+             * The upper half of this is the sequence number given to the
+             * scheduled callback when it was added, used to order callbacks
+             * due at the same time, and the lower half is the index of the
+             * slot holding the scheduled callback.  This way the due time
+             * and this together form a key which orders the heap.
+             */
+            uint64_t order;
+        };
+
+        // Private methods
+    private:
+        /**
+         * Return a new node for the scheduled callback in the given slot,
+         * ordered after every node made before it with the same due time.
+         *
+         * @param[in] slot
+         *     This is the index of the slot holding the scheduled callback.
+         *
+         * @return
+         *     The new node is returned.
+         */
+        Node MakeNode(size_t slot);
+
+        /**
+         * Give the nodes in the heap new sequence numbers, counting up
+         * from zero, in the same order as the ones they have, so that
+         * there's room to number more nodes.
+         */
+        void Renumber();
+
+        /**
+         * Determine whether or not the scheduled callback of the first
+         * given node should come before the one of the second given node.
+         *
+         * @param[in] first
+         *     This is the node of the first scheduled callback.
+         *
+         * @param[in] second
+         *     This is the node of the second scheduled callback.
+         *
+         * @return
+         *     An indication of whether or not the scheduled callback of the
+         *     first node should come before the one of the second node
+         *     is returned.
+         */
+        static bool Precedes(const Node& first, const Node& second) {
+            return (
+                (first.due < second.due)
+                | ((first.due == second.due) & (first.order < second.order))
+            );
+        }
+
+        /**
+         * Place the given node at the given heap position, updating the
+         * record of its position in the slot it refers to.
+         *
+         * @param[in] position
+         *     This is the heap position at which to place the node.
+         *
+         * @param[in] node
+         *     This is the node to place.
+         */
+        void Place(size_t position, const Node& node);
+
+        /**
+         * Move the scheduled callback at the given heap position towards
+         * the root of the heap until the heap is ordered again.
+         *
+         * @param[in] position
+         *     This is the heap position of the scheduled callback to move.
+         */
+        void SiftUp(size_t position);
+
+        /**
+         * Move the scheduled callback at the given heap position away from
+         * the root of the heap until the heap is ordered again.
+         *
+         * @param[in] position
+         *     This is the heap position of the scheduled callback to move.
+         */
+        void SiftDown(size_t position);
+
+        // Private properties
+    private:
+        /**
+         * This is the table of slots holding the scheduled callbacks.
+         */
+        SlotTable& slots_;
+
+        /**
+         * This holds the due times and slot indexes of the scheduled
+         * callbacks, arranged as a heap whose front element is the
+         * earliest due.
+         */
+        std::vector< Node > heap_;
+
+        /**
+         * This is the sequence number to give the next node made.
+         */
+        uint32_t nextSequence_;
+    };
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * @file TimerQueue.hpp
+ *
+ * This module declares the Timekeeping::TimerQueue interface.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "SlotTable.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Timekeeping {
+
+    /**
+     * This represents the data structure used by the scheduler to order
+     * scheduled callbacks until they become due.  The scheduled callbacks
+     * themselves are kept in a table of slots owned by the scheduler,
+     * and the queue only refers to them by slot index.
+     */
+    class TimerQueue {
+    public:
+        // Lifecycle Methods
+
+        virtual ~TimerQueue() noexcept = default;
+
+        // Methods
+
+        /**
+         * Add the scheduled callback in the given slot to the queue.
+         *
+         * @param[in] slot
+         *     This is the index of the slot holding the scheduled callback
+         *     to add to the queue.
+         */
+        virtual void Add(size_t slot) = 0;
+
+        /**
+         * Add the scheduled callbacks in the given slots to the queue.
+         *
+         * @param[in] slots
+         *     These are the indexes of the slots holding the scheduled
+         *     callbacks to add to the queue.
+         */
+        virtual void AddMany(const std::vector< size_t >& slots) {
+            for (const auto slot: slots) {
+                Add(slot);
+            }
+        }
+
+        /**
+         * Make room in the queue for at least the given number of
+         * scheduled callbacks, so that adding that many doesn't need
+         * to allocate memory.
+         *
+         * @param[in] count
+         *     This is the number of scheduled callbacks for which to
+         *     make room.
+         */
+        virtual void Reserve(size_t count) {
+            (void)count;
+        }
+
+        /**
+         * Release any memory the queue holds beyond what it needs for
+         * the scheduled callbacks it has now.
+         */
+        virtual void ShrinkToFit() {
+        }
+
+        /**
+         * Remove every scheduled callback from the queue at once, without
+         * touching the slots holding them, and release the memory the
+         * queue holds for them.
+         */
+        virtual void Clear() = 0;
+
+        /**
+         * Remove the scheduled callback in the given slot from the queue.
+         *
+         * @param[in] slot
+         *     This is the index of the slot holding the scheduled callback
+         *     to remove from the queue.  It must be in the queue.
+         */
+        virtual void Remove(size_t slot) = 0;
+
+        /**
+         * Determine whether or not the queue has no scheduled callbacks.
+         *
+         * @return
+         *     An indication of whether or not the queue has no scheduled
+         *     callbacks is returned.
+         */
+        virtual bool IsEmpty() const = 0;
+
+        /**
+         * Return the time at which the queue should next be examined
+         * for callbacks that have become due.
+         *
+         * @note
+         *     This should only be called when the queue is not empty.
+         *
+         * @return
+         *     The time, in ticks of the scheduler's clock, at which the
+         *     queue should next be examined for callbacks that have become
+         *     due is returned.
+         */
+        virtual int64_t GetNextDue() const = 0;
+
+        /**
+         * Remove the next scheduled callback which is due at or before
+         * the given time, if any.
+         *
+         * @param[in] now
+         *     This is the current time, in ticks of the scheduler's clock.
+         *
+         * @param[out] slot
+         *     This is where to store the index of the slot holding the
+         *     scheduled callback removed from the queue, if any.
+         *
+         * @return
+         *     An indication of whether or not a scheduled callback was
+         *     removed from the queue is returned.
+         */
+        virtual bool PopDue(
+            int64_t now,
+            size_t& slot
+        ) = 0;
+    };
+
+}
@@ -0,0 +1,29 @@
+/**
+ * @file TimerService.cpp
+ *
+ * This module contains the implementation of the Timekeeping::TimerService
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <Timekeeping/TimerService.hpp>
+
+namespace Timekeeping {
+
+    TimerService::~TimerService() noexcept = default;
+    TimerService::TimerService(TimerService&&) noexcept = default;
+    TimerService& TimerService::operator=(TimerService&&) noexcept = default;
+
+    TimerService::TimerService() = default;
+
+    TimerService::TimerService(const Scheduler::Configuration& configuration)
+        : engine_(configuration)
+    {
+    }
+
+    Scheduler TimerService::MakeScheduler() {
+        return Scheduler(engine_.impl_, true);
+    }
+
+}
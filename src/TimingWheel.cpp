@@ -0,0 +1,293 @@
+/**
+ * @file TimingWheel.cpp
+ *
+ * This module contains the implementation of the Timekeeping::TimingWheel
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TimingWheel.hpp"
+
+#include <algorithm>
+#include <Timekeeping/Clock.hpp>
+#include <utility>
+
+namespace {
+
+    /**
+     * This is the number of bits of a tick which select the slot
+     * within one level of the wheel.
+     */
+    constexpr unsigned int SLOT_BITS = 6;
+
+    /**
+     * This is used to select the slot bits of a tick, once shifted down
+     * to the level of interest.
+     */
+    constexpr uint64_t SLOT_MASK = (1 << SLOT_BITS) - 1;
+
+    /**
+     * Return the index of the least significant bit which is set in
+     * the given value.
+     *
+     * @param[in] value
+     *     This is the value to examine.  It must not be zero.
+     *
+     * @return
+     *     The index of the least significant bit which is set in
+     *     the given value is returned.
+     */
+    unsigned int FindFirstSet(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned int)__builtin_ctzll(value);
+#else
+        unsigned int index = 0;
+        while ((value & 1) == 0) {
+            value >>= 1;
+            ++index;
+        }
+        return index;
+#endif
+    }
+
+    /**
+     * Return the first tick of the span of ticks covered by one full
+     * rotation of the given level of the wheel, which contains the
+     * given tick.
+     *
+     * @param[in] tick
+     *     This is the tick for which to find the start of the span.
+     *
+     * @param[in] level
+     *     This is the level of the wheel whose rotation defines the span.
+     *
+     * @return
+     *     The first tick of the span is returned.
+     */
+    uint64_t RotationStart(uint64_t tick, size_t level) {
+        const auto shift = SLOT_BITS * (level + 1);
+        if (shift >= 64) {
+            return 0;
+        }
+        return (tick >> shift) << shift;
+    }
+
+}
+
+namespace Timekeeping {
+
+    constexpr size_t TimingWheel::SLOTS_PER_LEVEL;
+    constexpr size_t TimingWheel::LEVELS;
+    constexpr size_t TimingWheel::READY_LIST;
+
+    TimingWheel::TimingWheel(
+        SlotTable& slots,
+        double tickResolution
+    )
+        : slots_(slots)
+        , tickLength_(std::max((int64_t)1, Clock::SecondsToTicks(tickResolution)))
+    {
+    }
+
+    void TimingWheel::Add(size_t slot) {
+        Insert(slot);
+    }
+
+    void TimingWheel::Remove(size_t slot) {
+        const auto list = slots_[slot].queuePosition;
+        Unlink(slot);
+        if (list == READY_LIST) {
+            return;
+        }
+        --count_;
+        if (lists_[list].head == NO_SLOT) {
+            occupied_[list / SLOTS_PER_LEVEL] &= ~(
+                (uint64_t)1 << (list % SLOTS_PER_LEVEL)
+            );
+        }
+    }
+
+    void TimingWheel::Clear() {
+        for (auto& list: lists_) {
+            list.head = NO_SLOT;
+            list.tail = NO_SLOT;
+        }
+        for (auto& levelOccupied: occupied_) {
+            levelOccupied = 0;
+        }
+        count_ = 0;
+    }
+
+    bool TimingWheel::IsEmpty() const {
+        return (
+            (count_ == 0)
+            && (lists_[READY_LIST].head == NO_SLOT)
+        );
+    }
+
+    int64_t TimingWheel::GetNextDue() const {
+        const auto ready = lists_[READY_LIST].head;
+        if (ready != NO_SLOT) {
+            return slots_[ready].due;
+        }
+        const auto nextEventTick = GetNextEventTick();
+        if (nextEventTick > (uint64_t)(INT64_MAX / tickLength_)) {
+            return INT64_MAX;
+        }
+        return (int64_t)nextEventTick * tickLength_;
+    }
+
+    bool TimingWheel::PopDue(
+        int64_t now,
+        size_t& slot
+    ) {
+        if (lists_[READY_LIST].head == NO_SLOT) {
+            Advance(NowToTick(now));
+            if (lists_[READY_LIST].head == NO_SLOT) {
+                return false;
+            }
+        }
+        slot = lists_[READY_LIST].head;
+        Unlink(slot);
+        return true;
+    }
+
+    uint64_t TimingWheel::DueToTick(int64_t due) const {
+        if (due <= 0) {
+            return 0;
+        }
+        return (uint64_t)(due / tickLength_ + ((due % tickLength_ == 0) ? 0 : 1));
+    }
+
+    uint64_t TimingWheel::NowToTick(int64_t now) const {
+        if (now <= 0) {
+            return 0;
+        }
+        return (uint64_t)(now / tickLength_);
+    }
+
+    void TimingWheel::Insert(size_t slot) {
+        const auto tick = DueToTick(slots_[slot].due);
+        if (tick < currentTick_) {
+            Append(READY_LIST, slot);
+            return;
+        }
+        size_t level = 0;
+        auto difference = (tick ^ currentTick_) >> SLOT_BITS;
+        while (difference != 0) {
+            ++level;
+            difference >>= SLOT_BITS;
+        }
+        const auto levelSlot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+        Append(level * SLOTS_PER_LEVEL + levelSlot, slot);
+        occupied_[level] |= ((uint64_t)1 << levelSlot);
+        ++count_;
+    }
+
+    void TimingWheel::Append(size_t list, size_t slot) {
+        auto& scheduledCallback = slots_[slot];
+        scheduledCallback.queuePosition = list;
+        scheduledCallback.next = NO_SLOT;
+        scheduledCallback.previous = lists_[list].tail;
+        if (lists_[list].tail == NO_SLOT) {
+            lists_[list].head = slot;
+        } else {
+            slots_[lists_[list].tail].next = slot;
+        }
+        lists_[list].tail = slot;
+    }
+
+    void TimingWheel::Unlink(size_t slot) {
+        auto& scheduledCallback = slots_[slot];
+        auto& list = lists_[scheduledCallback.queuePosition];
+        if (scheduledCallback.previous == NO_SLOT) {
+            list.head = scheduledCallback.next;
+        } else {
+            slots_[scheduledCallback.previous].next = scheduledCallback.next;
+        }
+        if (scheduledCallback.next == NO_SLOT) {
+            list.tail = scheduledCallback.previous;
+        } else {
+            slots_[scheduledCallback.next].previous = scheduledCallback.previous;
+        }
+        scheduledCallback.queuePosition = NO_SLOT;
+        scheduledCallback.next = NO_SLOT;
+        scheduledCallback.previous = NO_SLOT;
+    }
+
+    uint64_t TimingWheel::GetNextEventTick() const {
+        auto nextEventTick = UINT64_MAX;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            const auto occupied = occupied_[level];
+            if (occupied == 0) {
+                continue;
+            }
+            const uint64_t levelSlot = FindFirstSet(occupied);
+            const auto eventTick = (
+                RotationStart(currentTick_, level)
+                | (levelSlot << (SLOT_BITS * level))
+            );
+            if (eventTick < nextEventTick) {
+                nextEventTick = eventTick;
+            }
+        }
+        return nextEventTick;
+    }
+
+    void TimingWheel::Advance(uint64_t tick) {
+        while (count_ > 0) {
+            const auto nextEventTick = GetNextEventTick();
+            if (nextEventTick > tick) {
+                break;
+            }
+            currentTick_ = nextEventTick;
+
+            // Cascade any higher-level slots which begin at this tick,
+            // working downwards so that callbacks can cascade through
+            // more than one level in a single step.
+            for (auto level = LEVELS - 1; level > 0; --level) {
+                const auto shift = SLOT_BITS * level;
+                if ((currentTick_ & (((uint64_t)1 << shift) - 1)) != 0) {
+                    continue;
+                }
+                const auto levelSlot = (currentTick_ >> shift) & SLOT_MASK;
+                const auto levelSlotBit = ((uint64_t)1 << levelSlot);
+                if ((occupied_[level] & levelSlotBit) == 0) {
+                    continue;
+                }
+                occupied_[level] &= ~levelSlotBit;
+                auto& list = lists_[level * SLOTS_PER_LEVEL + levelSlot];
+                auto slot = list.head;
+                list.head = list.tail = NO_SLOT;
+                while (slot != NO_SLOT) {
+                    const auto next = slots_[slot].next;
+                    --count_;
+                    Insert(slot);
+                    slot = next;
+                }
+            }
+
+            // Expire the level-0 slot for this tick.
+            const auto levelSlot = currentTick_ & SLOT_MASK;
+            const auto levelSlotBit = ((uint64_t)1 << levelSlot);
+            if ((occupied_[0] & levelSlotBit) != 0) {
+                occupied_[0] &= ~levelSlotBit;
+                auto& list = lists_[levelSlot];
+                auto slot = list.head;
+                list.head = list.tail = NO_SLOT;
+                while (slot != NO_SLOT) {
+                    const auto next = slots_[slot].next;
+                    --count_;
+                    Append(READY_LIST, slot);
+                    slot = next;
+                }
+            }
+            ++currentTick_;
+        }
+        if (tick >= currentTick_) {
+            currentTick_ = tick + 1;
+        }
+    }
+
+}
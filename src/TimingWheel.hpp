@@ -0,0 +1,219 @@
+#pragma once
+
+/**
+ * @file TimingWheel.hpp
+ *
+ * This module declares the Timekeeping::TimingWheel class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include "TimerQueue.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Timekeeping {
+
+    /**
+     * This is a timer queue which keeps scheduled callbacks in a
+     * hierarchical timing wheel.  Time is divided into ticks of a fixed
+     * resolution, and each level of the wheel has 64 slots, each covering
+     * 64 times as many ticks as a slot in the level below it.  Adding a
+     * callback is constant time, and callbacks are carried down ("cascaded")
+     * a level at a time as their due time approaches.  Each slot of the
+     * wheel is an intrusive list threaded through the scheduled callbacks
+     * themselves, so that removing a callback is also constant time.
+     *
+     * Callbacks are never called before they are due, but may be called
+     * up to one tick after they are due, and callbacks due within the
+     * same tick are called in no particular order.
+     */
+    class TimingWheel
+        : public TimerQueue
+    {
+        // Public Methods
+    public:
+        /**
+         * This is the constructor of the class.
+         *
+         * @param[in] slots
+         *     This is the table of slots holding the scheduled callbacks
+         *     which the wheel orders.
+         *
+         * @param[in] tickResolution
+         *     This is the length of one tick of the wheel, in the same
+         *     units (typically seconds) as the scheduler's clock.
+         */
+        TimingWheel(
+            SlotTable& slots,
+            double tickResolution
+        );
+
+        // TimerQueue
+
+        virtual void Add(size_t slot) override;
+        virtual void Remove(size_t slot) override;
+        virtual void Clear() override;
+        virtual bool IsEmpty() const override;
+        virtual int64_t GetNextDue() const override;
+        virtual bool PopDue(
+            int64_t now,
+            size_t& slot
+        ) override;
+
+        // Private methods
+    private:
+        /**
+         * Convert the given due time to the first wheel tick at which the
+         * callback is due.
+         *
+         * @param[in] due
+         *     This is the due time to convert, in ticks of the clock.
+         *
+         * @return
+         *     The first wheel tick at which a callback with the given due
+         *     time is due is returned.
+         */
+        uint64_t DueToTick(int64_t due) const;
+
+        /**
+         * Convert the given clock time to the last wheel tick which has
+         * begun at that time.
+         *
+         * @param[in] now
+         *     This is the clock time to convert, in ticks of the clock.
+         *
+         * @return
+         *     The last wheel tick which has begun at the given time is
+         *     returned.
+         */
+        uint64_t NowToTick(int64_t now) const;
+
+        /**
+         * Place the given scheduled callback in the appropriate slot of the
+         * wheel, relative to the current tick, or in the list of callbacks
+         * ready to be called, if its tick has already been processed.
+         *
+         * @param[in] slot
+         *     This is the index of the table slot holding the scheduled
+         *     callback to place in the wheel.
+         */
+        void Insert(size_t slot);
+
+        /**
+         * Append the given table slot to the end of the given list.
+         *
+         * @param[in] list
+         *     This is the index of the list to which to append the slot.
+         *
+         * @param[in] slot
+         *     This is the index of the table slot to append.
+         */
+        void Append(size_t list, size_t slot);
+
+        /**
+         * Remove the given table slot from the list it's in.
+         *
+         * @param[in] slot
+         *     This is the index of the table slot to remove.
+         */
+        void Unlink(size_t slot);
+
+        /**
+         * Return the next tick at which a slot of the wheel needs to be
+         * either cascaded or expired.
+         *
+         * @note
+         *     This should only be called when the wheel is not empty.
+         *
+         * @return
+         *     The next tick at which a slot of the wheel needs to be
+         *     either cascaded or expired is returned.
+         */
+        uint64_t GetNextEventTick() const;
+
+        /**
+         * Process every tick of the wheel up to and including the given
+         * tick, moving callbacks which become due to the list of callbacks
+         * ready to be called.
+         *
+         * @param[in] tick
+         *     This is the last tick to process.
+         */
+        void Advance(uint64_t tick);
+
+        // Private properties
+    private:
+        /**
+         * This is the number of slots in each level of the wheel.
+         */
+        static constexpr size_t SLOTS_PER_LEVEL = 64;
+
+        /**
+         * This is the number of levels in the wheel, which is enough
+         * to cover the full 64-bit range of ticks.
+         */
+        static constexpr size_t LEVELS = 11;
+
+        /**
+         * This is the index of the list holding scheduled callbacks
+         * which have become due.  It comes after the lists of all
+         * the slots of all the levels of the wheel.
+         */
+        static constexpr size_t READY_LIST = SLOTS_PER_LEVEL * LEVELS;
+
+        /**
+         * This holds the two ends of one intrusive list of table slots.
+         */
+        struct List {
+            /**
+             * This is the index of the first table slot in the list.
+             */
+            size_t head = NO_SLOT;
+
+            /**
+             * This is the index of the last table slot in the list.
+             */
+            size_t tail = NO_SLOT;
+        };
+
+        /**
+         * This is the table of slots holding the scheduled callbacks.
+         */
+        SlotTable& slots_;
+
+        /**
+         * This is the length of one tick of the wheel, in ticks of the
+         * clock.
+         */
+        int64_t tickLength_;
+
+        /**
+         * This is the next tick of the wheel to be processed.
+         */
+        uint64_t currentTick_ = 0;
+
+        /**
+         * This is the number of scheduled callbacks held in the slots
+         * of the wheel.
+         */
+        size_t count_ = 0;
+
+        /**
+         * This has, for each level of the wheel, one bit set for each
+         * slot of the level which holds at least one scheduled callback.
+         */
+        uint64_t occupied_[LEVELS] = {0};
+
+        /**
+         * These are the lists of scheduled callbacks in the slots of
+         * the wheel, level by level, followed by the list of scheduled
+         * callbacks which have become due and are waiting to be removed
+         * from the queue.
+         */
+        List lists_[READY_LIST + 1];
+    };
+
+}
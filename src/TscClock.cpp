@@ -0,0 +1,162 @@
+/**
+ * @file TscClock.cpp
+ *
+ * This module contains the implementation of the Timekeeping::TscClock
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <Timekeeping/TscClock.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TIMEKEEPING_HAVE_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define TIMEKEEPING_HAVE_TSC
+#endif
+
+namespace {
+
+    /**
+     * Read the steady clock, in ticks.
+     *
+     * @return
+     *     The current time of the steady clock, in ticks, is returned.
+     */
+    int64_t GetSteadyTicks() {
+        return (int64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+
+#ifdef TIMEKEEPING_HAVE_TSC
+    /**
+     * Read the processor's time stamp counter.
+     *
+     * @return
+     *     The current value of the time stamp counter is returned.
+     */
+    uint64_t GetCycles() {
+        return (uint64_t)__rdtsc();
+    }
+
+#ifdef __SIZEOF_INT128__
+    /**
+     * This is the compiler's 128-bit unsigned integer, which isn't part of
+     * standard C++.
+     */
+    __extension__ typedef unsigned __int128 Uint128;
+#endif
+
+    /**
+     * Return the given number of ticks per the given number of cycles, as
+     * a fixed-point number with 32 fractional bits.
+     *
+     * @param[in] ticks
+     *     This is the number of ticks measured.
+     *
+     * @param[in] cycles
+     *     This is the number of cycles measured over the same time.
+     *
+     * @return
+     *     The number of ticks per cycle, with 32 fractional bits, is
+     *     returned.
+     */
+    uint64_t GetTicksPerCycle(uint64_t ticks, uint64_t cycles) {
+        // Shifting the ticks left by 32 bits would overflow 64 bits for
+        // any calibration longer than about 4.29 seconds.
+#ifdef __SIZEOF_INT128__
+        return (uint64_t)(((Uint128)ticks << 32) / cycles);
+#else
+        return (uint64_t)((long double)ticks * 4294967296.0L / (long double)cycles);
+#endif
+    }
+
+    /**
+     * Convert the given number of cycles to ticks.
+     *
+     * @param[in] cycles
+     *     This is the number of cycles to convert.
+     *
+     * @param[in] ticksPerCycle
+     *     This is the number of ticks per cycle, as a fixed-point number
+     *     with 32 fractional bits.
+     *
+     * @return
+     *     The number of ticks is returned.
+     */
+    uint64_t CyclesToTicks(uint64_t cycles, uint64_t ticksPerCycle) {
+#ifdef __SIZEOF_INT128__
+        return (uint64_t)(((Uint128)cycles * ticksPerCycle) >> 32);
+#else
+        // Multiply the upper and lower halves of each factor separately,
+        // since ticksPerCycle itself exceeds 32 bits when the counter runs
+        // slower than about 1 GHz, so that no product overflows.
+        const auto cyclesHigh = (cycles >> 32);
+        const auto cyclesLow = (cycles & 0xFFFFFFFF);
+        const auto ticksPerCycleHigh = (ticksPerCycle >> 32);
+        const auto ticksPerCycleLow = (ticksPerCycle & 0xFFFFFFFF);
+        return (
+            ((cyclesHigh * ticksPerCycleHigh) << 32)
+            + cyclesHigh * ticksPerCycleLow
+            + cyclesLow * ticksPerCycleHigh
+            + ((cyclesLow * ticksPerCycleLow) >> 32)
+        );
+#endif
+    }
+#endif
+
+}
+
+namespace Timekeeping {
+
+    TscClock::TscClock(double calibrationTime) {
+#ifdef TIMEKEEPING_HAVE_TSC
+        // Spin rather than sleep, so that the end of calibration is
+        // sampled as close as possible to when it's reached.
+        const auto calibrationTicks = std::max(
+            (int64_t)1000000,
+            SecondsToTicks(std::min(calibrationTime, 10.0))
+        );
+        const auto startTicks = GetSteadyTicks();
+        const auto startCycles = GetCycles();
+        auto endTicks = startTicks;
+        while (endTicks - startTicks < calibrationTicks) {
+            endTicks = GetSteadyTicks();
+        }
+        const auto endCycles = GetCycles();
+        if (endCycles > startCycles) {
+            baseCycles_ = endCycles;
+            baseTicks_ = endTicks;
+            ticksPerCycle_ = GetTicksPerCycle(
+                (uint64_t)(endTicks - startTicks),
+                endCycles - startCycles
+            );
+        }
+#else
+        (void)calibrationTime;
+#endif
+    }
+
+    bool TscClock::IsUsingTsc() const {
+        return (ticksPerCycle_ != 0);
+    }
+
+    int64_t TscClock::GetCurrentTicks() {
+#ifdef TIMEKEEPING_HAVE_TSC
+        if (ticksPerCycle_ != 0) {
+            // The counter may read very slightly behind the base on a
+            // different core, so never go back past the base.
+            const auto cycles = GetCycles();
+            const auto elapsed = (cycles > baseCycles_) ? (cycles - baseCycles_) : 0;
+            return baseTicks_ + (int64_t)CyclesToTicks(elapsed, ticksPerCycle_);
+        }
+#endif
+        return GetSteadyTicks();
+    }
+
+}
@@ -0,0 +1,125 @@
+/**
+ * @file ClockTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::Clock class
+ * and the clocks built on it.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdint.h>
+#include <thread>
+#include <Timekeeping/Clock.hpp>
+#include <Timekeeping/CoarseMonotonicClock.hpp>
+#include <Timekeeping/SteadyClock.hpp>
+#include <Timekeeping/TickClock.hpp>
+#include <Timekeeping/TscClock.hpp>
+
+namespace {
+
+    /**
+     * This is a fake clock which counts time in seconds.
+     */
+    struct SecondsClock
+        : public Timekeeping::Clock
+    {
+        // Properties
+
+        double currentTime = 0.0;
+
+        // Methods
+
+        // Clock
+
+        virtual double GetCurrentTime() override {
+            return currentTime;
+        }
+    };
+
+    /**
+     * This is a fake clock which counts time in ticks.
+     */
+    struct TicksClock
+        : public Timekeeping::TickClock
+    {
+        // Properties
+
+        int64_t currentTicks = 0;
+
+        // Methods
+
+        // Timekeeping::TickClock
+
+        virtual int64_t GetCurrentTicks() override {
+            return currentTicks;
+        }
+    };
+
+}
+
+TEST(ClockTests, SecondsToTicksRoundsToNearestTick) {
+    EXPECT_EQ(1500000000, Timekeeping::Clock::SecondsToTicks(1.5));
+    EXPECT_EQ(-250000000, Timekeeping::Clock::SecondsToTicks(-0.25));
+    EXPECT_EQ(1, Timekeeping::Clock::SecondsToTicks(0.0000000006));
+}
+
+TEST(ClockTests, SecondsToTicksSaturates) {
+    EXPECT_EQ(INT64_MAX, Timekeeping::Clock::SecondsToTicks(1e300));
+    EXPECT_EQ(INT64_MAX, Timekeeping::Clock::SecondsToTicks(HUGE_VAL));
+    EXPECT_EQ(INT64_MIN, Timekeeping::Clock::SecondsToTicks(-1e300));
+}
+
+TEST(ClockTests, DefaultTicksAreConvertedFromSeconds) {
+    // Arrange
+    SecondsClock clock;
+    clock.currentTime = 2.000000003;
+
+    // Act
+    const auto ticks = clock.GetCurrentTicks();
+
+    // Assert
+    EXPECT_EQ(2000000003, ticks);
+}
+
+TEST(ClockTests, TickClockConvertsTicksToSeconds) {
+    // Arrange
+    TicksClock clock;
+    clock.currentTicks = 1546300800123456789;
+
+    // Act
+    const auto seconds = clock.GetCurrentTime();
+
+    // Assert
+    EXPECT_EQ(1546300800123456789, clock.GetCurrentTicks());
+    EXPECT_DOUBLE_EQ(1546300800.123456789, seconds);
+}
+
+TEST(ClockTests, StockClocksAreMonotonicAndAgreeWithSteadyClock) {
+    // Arrange
+    Timekeeping::SteadyClock steadyClock;
+    Timekeeping::CoarseMonotonicClock coarseClock;
+    Timekeeping::TscClock tscClock;
+    Timekeeping::Clock* clocks[] = {&steadyClock, &coarseClock, &tscClock};
+    int64_t before[3];
+    for (size_t i = 0; i < 3; ++i) {
+        before[i] = clocks[i]->GetCurrentTicks();
+    }
+
+    // Act
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int64_t after[3];
+    for (size_t i = 0; i < 3; ++i) {
+        after[i] = clocks[i]->GetCurrentTicks();
+    }
+
+    // Assert
+    const auto slack = Timekeeping::Clock::SecondsToTicks(0.01);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_GE(after[i] - before[i], Timekeeping::Clock::SecondsToTicks(0.02) - slack) << i;
+        EXPECT_LT(after[i] - after[0], slack) << i;
+        EXPECT_GT(after[i] - after[0], -slack) << i;
+    }
+}
@@ -0,0 +1,342 @@
+/**
+ * @file CoroutinesTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::SleepUntil and
+ * Timekeeping::SleepFor functions and Timekeeping::Scheduler methods.  They're only built when compiling
+ * with coroutine support.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <gtest/gtest.h>
+#include <Timekeeping/Coroutines.hpp>
+
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <Timekeeping/Scheduler.hpp>
+#include <Timekeeping/TickClock.hpp>
+
+namespace {
+
+    /**
+     * This is a fake clock which is used to test sleeping coroutines.
+     */
+    struct MockTickClock
+        : public Timekeeping::TickClock
+    {
+        // Properties
+
+        std::atomic< int64_t > currentTicks{0};
+
+        // Methods
+
+        // TickClock
+
+        virtual int64_t GetCurrentTicks() override {
+            return currentTicks;
+        }
+    };
+
+    /**
+     * This is the simplest coroutine type which can be used to test
+     * sleeping coroutines.  It starts running right away, and its frame
+     * is destroyed along with it.
+     */
+    struct Task {
+        // Types
+
+        struct promise_type {
+            Task get_return_object() {
+                return Task{std::coroutine_handle< promise_type >::from_promise(*this)};
+            }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        // Lifecycle
+
+        ~Task() noexcept {
+            if (coroutine) {
+                coroutine.destroy();
+            }
+        }
+        Task(const Task&) = delete;
+        Task(Task&& other) noexcept
+            : coroutine(other.coroutine)
+        {
+            other.coroutine = nullptr;
+        }
+        Task& operator=(const Task&) = delete;
+        Task& operator=(Task&&) = delete;
+
+        explicit Task(std::coroutine_handle< promise_type > coroutine)
+            : coroutine(coroutine)
+        {
+        }
+
+        // Properties
+
+        std::coroutine_handle< promise_type > coroutine;
+    };
+
+    /**
+     * This is a coroutine which sleeps until the given due time on the
+     * given scheduler the given number of times, counting how many times
+     * it woke up.
+     *
+     * @param[in] scheduler
+     *     This is the scheduler on which to sleep.
+     *
+     * @param[in] due
+     *     This is the due time of the first wake-up, in ticks.  Each
+     *     later wake-up is one tick later than the one before it.
+     *
+     * @param[in] times
+     *     This is how many times to sleep.
+     *
+     * @param[in,out] wakeUps
+     *     This is where to count the wake-ups.
+     *
+     * @return
+     *     The coroutine is returned.
+     */
+    Task Sleeper(
+        Timekeeping::Scheduler& scheduler,
+        std::chrono::nanoseconds due,
+        int times,
+        int& wakeUps
+    ) {
+        for (int i = 0; i < times; ++i) {
+            co_await Timekeeping::SleepUntil(scheduler, due + std::chrono::nanoseconds(i));
+            ++wakeUps;
+        }
+    }
+
+}
+
+/**
+ * This is the test fixture for these tests, providing common
+ * setup and teardown for each test.
+ */
+struct CoroutinesTests
+    : public ::testing::Test
+{
+    // Properties
+
+    std::shared_ptr< MockTickClock > mockClock = std::make_shared< MockTickClock >();
+    std::unique_ptr< Timekeeping::Scheduler > scheduler;
+
+    // Methods
+
+    // ::testing::Test
+
+    virtual void SetUp() override {
+        Timekeeping::Scheduler::Configuration configuration;
+        configuration.threadless = true;
+        scheduler.reset(new Timekeeping::Scheduler(configuration));
+        scheduler->SetClock(mockClock);
+    }
+
+    virtual void TearDown() override {
+    }
+};
+
+TEST_F(CoroutinesTests, SleepUntilResumesCoroutineAtDueTime) {
+    // Arrange
+    int wakeUps = 0;
+    const auto task = Sleeper(*scheduler, std::chrono::nanoseconds(100), 2, wakeUps);
+
+    // Act
+    const auto calledEarly = scheduler->RunDue(std::chrono::nanoseconds(99));
+    const auto wakeUpsEarly = wakeUps;
+    const auto calledAtFirstDue = scheduler->RunDue(std::chrono::nanoseconds(100));
+    const auto wakeUpsAtFirstDue = wakeUps;
+    const auto calledAtSecondDue = scheduler->RunDue(std::chrono::nanoseconds(101));
+
+    // Assert
+    EXPECT_EQ(0u, calledEarly);
+    EXPECT_EQ(0, wakeUpsEarly);
+    EXPECT_EQ(1u, calledAtFirstDue);
+    EXPECT_EQ(1, wakeUpsAtFirstDue);
+    EXPECT_EQ(1u, calledAtSecondDue);
+    EXPECT_EQ(2, wakeUps);
+    EXPECT_TRUE(task.coroutine.done());
+}
+
+TEST_F(CoroutinesTests, SleepForCountsFromNow) {
+    // Arrange
+    mockClock->currentTicks = 1000;
+    bool wokeUp = false;
+    const auto coroutine = [](
+        Timekeeping::Scheduler& scheduler,
+        bool& wokeUp
+    ) -> Task {
+        co_await Timekeeping::SleepFor(scheduler, std::chrono::nanoseconds(50));
+        wokeUp = true;
+    };
+    const auto task = coroutine(*scheduler, wokeUp);
+
+    // Act
+    const auto deadline = scheduler->GetNextDeadline();
+    (void)scheduler->RunDue(deadline);
+
+    // Assert
+    EXPECT_EQ(std::chrono::nanoseconds(1050), deadline);
+    EXPECT_TRUE(wokeUp);
+}
+
+TEST_F(CoroutinesTests, SchedulerMethodsCanBeAwaited) {
+    // Arrange
+    mockClock->currentTicks = 1000;
+    int wakeUps = 0;
+    const auto coroutine = [](
+        Timekeeping::Scheduler& scheduler,
+        int& wakeUps
+    ) -> Task {
+        co_await scheduler.SleepUntil(std::chrono::nanoseconds(1010));
+        ++wakeUps;
+        co_await scheduler.SleepFor(std::chrono::nanoseconds(20));
+        ++wakeUps;
+    };
+    const auto task = coroutine(*scheduler, wakeUps);
+
+    // Act
+    const auto firstDeadline = scheduler->GetNextDeadline();
+    (void)scheduler->RunDue(firstDeadline);
+    const auto secondDeadline = scheduler->GetNextDeadline();
+    (void)scheduler->RunDue(secondDeadline);
+
+    // Assert
+    EXPECT_EQ(std::chrono::nanoseconds(1010), firstDeadline);
+    EXPECT_EQ(std::chrono::nanoseconds(1020), secondDeadline);
+    EXPECT_EQ(2, wakeUps);
+    EXPECT_TRUE(task.coroutine.done());
+}
+
+TEST_F(CoroutinesTests, DestroyingSleepingCoroutineCancelsItsCallback) {
+    // Arrange
+    int wakeUps = 0;
+    auto task = std::unique_ptr< Task >(
+        new Task(Sleeper(*scheduler, std::chrono::nanoseconds(100), 1, wakeUps))
+    );
+    const auto pendingBefore = scheduler->GetStatistics().pending;
+
+    // Act
+    task.reset();
+    const auto called = scheduler->RunDue(std::chrono::nanoseconds(100));
+
+    // Assert
+    EXPECT_EQ(1u, pendingBefore);
+    EXPECT_EQ(0u, scheduler->GetStatistics().pending);
+    EXPECT_EQ(0u, called);
+    EXPECT_EQ(0, wakeUps);
+}
+
+TEST_F(CoroutinesTests, SleepingCoroutineIsResumedByWorkerThread) {
+    // Arrange
+    scheduler.reset(new Timekeeping::Scheduler());
+    scheduler->SetClock(mockClock);
+    std::atomic< bool > wokeUp{false};
+    const auto coroutine = [](
+        Timekeeping::Scheduler& scheduler,
+        std::atomic< bool >& wokeUp
+    ) -> Task {
+        co_await Timekeeping::SleepUntil(scheduler, std::chrono::nanoseconds(10));
+        wokeUp = true;
+    };
+    const auto task = coroutine(*scheduler, wokeUp);
+
+    // Act
+    mockClock->currentTicks = 10;
+    (void)scheduler->Schedule([]{}, std::chrono::nanoseconds(0));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (
+        !wokeUp
+        && (std::chrono::steady_clock::now() < deadline)
+    ) {
+        std::this_thread::yield();
+    }
+
+    // Destroying the scheduler waits for the worker thread, which is
+    // still running the coroutine until it's suspended for the last time.
+    scheduler.reset();
+
+    // Assert
+    EXPECT_TRUE(wokeUp);
+    EXPECT_TRUE(task.coroutine.done());
+}
+
+TEST_F(CoroutinesTests, DestroyingCoroutineWhoseCallbackWasDroppedDoesNotWait) {
+    // Arrange
+    int wakeUps = 0;
+    auto task = std::unique_ptr< Task >(
+        new Task(Sleeper(*scheduler, std::chrono::nanoseconds(100), 1, wakeUps))
+    );
+    const auto dropped = scheduler->Shutdown(
+        Timekeeping::Scheduler::ShutdownPolicy::DropAll
+    );
+
+    // Act
+    const auto doneBeforeDestroyed = task->coroutine.done();
+    task.reset();
+
+    // Assert
+    EXPECT_EQ(1u, dropped);
+    EXPECT_FALSE(doneBeforeDestroyed);
+    EXPECT_EQ(0, wakeUps);
+}
+
+TEST_F(CoroutinesTests, CoroutineIsNotSuspendedWhenCallbackCannotBeScheduled) {
+    // Arrange
+    scheduler->SetClock(nullptr);
+    bool wokeUp = false;
+    const auto coroutine = [](
+        Timekeeping::Scheduler& scheduler,
+        bool& wokeUp
+    ) -> Task {
+        co_await Timekeeping::SleepFor(scheduler, std::chrono::nanoseconds(50));
+        wokeUp = true;
+    };
+
+    // Act
+    auto task = std::unique_ptr< Task >(new Task(coroutine(*scheduler, wokeUp)));
+    const auto done = task->coroutine.done();
+    task.reset();
+
+    // Assert
+    EXPECT_TRUE(wokeUp);
+    EXPECT_TRUE(done);
+    EXPECT_EQ(0u, scheduler->GetStatistics().pending);
+}
+
+TEST_F(CoroutinesTests, DestroyingSleepingCoroutineCancelsItsCallbackWithLockFreeSubmission) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.lockFreeSubmission = true;
+    scheduler.reset(new Timekeeping::Scheduler(configuration));
+    scheduler->SetClock(mockClock);
+    int wakeUps = 0;
+    auto task = std::unique_ptr< Task >(
+        new Task(Sleeper(*scheduler, std::chrono::nanoseconds(100), 1, wakeUps))
+    );
+
+    // Act
+    task.reset();
+    const auto called = scheduler->RunDue(std::chrono::nanoseconds(100));
+
+    // Assert
+    EXPECT_EQ(0u, called);
+    EXPECT_EQ(0, wakeUps);
+    EXPECT_EQ(0u, scheduler->GetStatistics().pending);
+}
+
+#endif /* defined(__cpp_impl_coroutine) */
@@ -6,10 +6,30 @@
  * © 2018 by Richard Walters
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <future>
 #include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+#include <string>
+#include <thread>
 #include <Timekeeping/Clock.hpp>
+#include <Timekeeping/Executor.hpp>
 #include <Timekeeping/Scheduler.hpp>
+#include <Timekeeping/SteadyClock.hpp>
+#include <Timekeeping/TickClock.hpp>
+#include <Timekeeping/Tracer.hpp>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
 
 namespace {
 
@@ -32,6 +52,170 @@ namespace {
         }
     };
 
+    /**
+     * This is a clock which reads the system's steady clock, used to test
+     * how closely the scheduler keeps to real time.
+     */
+    struct SteadyTestClock
+        : public Timekeeping::Clock
+    {
+        // Methods
+
+        // Clock
+
+        virtual double GetCurrentTime() override {
+            return std::chrono::duration< double >(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count();
+        }
+    };
+
+    /**
+     * This is a fake executor which is used to test the scheduler.
+     * It simply holds onto the tasks it's given, so that the test
+     * can run them.
+     */
+    struct MockExecutor
+        : public Timekeeping::Executor
+    {
+        // Properties
+
+        std::mutex mutex;
+        std::condition_variable tasksReceived;
+        std::vector< std::pair< Task, uint64_t > > tasks;
+
+        // Methods
+
+        bool AwaitTasks(size_t numTasks) {
+            std::unique_lock< decltype(mutex) > lock(mutex);
+            return tasksReceived.wait_for(
+                lock,
+                std::chrono::seconds(1),
+                [this, numTasks]{ return tasks.size() >= numTasks; }
+            );
+        }
+
+        // Executor
+
+        virtual void Execute(
+            Task task,
+            uint64_t strand
+        ) override {
+            std::lock_guard< decltype(mutex) > lock(mutex);
+            tasks.emplace_back(std::move(task), strand);
+            tasksReceived.notify_all();
+        }
+    };
+
+    /**
+     * This counts calls of a callback, and lets the test wait for
+     * the callback to be called some number of times.
+     */
+    struct CallCounter {
+        // Properties
+
+        std::mutex mutex;
+        std::condition_variable called;
+        size_t calls = 0;
+
+        // Methods
+
+        void Call() {
+            std::lock_guard< decltype(mutex) > lock(mutex);
+            ++calls;
+            called.notify_all();
+        }
+
+        bool AwaitCalls(size_t numCalls) {
+            std::unique_lock< decltype(mutex) > lock(mutex);
+            return called.wait_for(
+                lock,
+                std::chrono::seconds(1),
+                [this, numCalls]{ return calls >= numCalls; }
+            );
+        }
+
+        size_t GetCalls() {
+            std::lock_guard< decltype(mutex) > lock(mutex);
+            return calls;
+        }
+    };
+
+    /**
+     * Return a request to schedule the given callback at the given
+     * due time.
+     *
+     * @param[in] callback
+     *     This is the function to schedule.
+     *
+     * @param[in] due
+     *     This is the due time, in clock ticks, of the callback.
+     *
+     * @return
+     *     The request to schedule the callback is returned.
+     */
+    Timekeeping::Scheduler::ScheduleRequest MakeRequest(
+        Timekeeping::Scheduler::Callback callback,
+        std::chrono::nanoseconds due
+    ) {
+        Timekeeping::Scheduler::ScheduleRequest request;
+        request.callback = std::move(callback);
+        request.due = due;
+        return request;
+    }
+
+    /**
+     * This counts the blocks of memory allocated by the program with
+     * the global operator new.
+     */
+    std::atomic< size_t > allocations{0};
+
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    const auto block = malloc((size == 0) ? 1 : size);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    ++allocations;
+    return malloc((size == 0) ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept {
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    free(pointer);
 }
 
 /**
@@ -114,9 +298,31 @@ TEST_F(SchedulerTests, Cancel) {
     EXPECT_FALSE(wasCalledOnTime);
 }
 
+TEST_F(SchedulerTests, CancelReportsWhetherCallbackWasStillScheduled) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto canceledToken = scheduler.Schedule([]{}, 1.0);
+    const auto calledToken = scheduler.Schedule([]{}, 1.0);
+
+    // Act
+    const auto firstCancel = scheduler.Cancel(canceledToken);
+    const auto secondCancel = scheduler.Cancel(canceledToken);
+    (void)scheduler.RunDue(std::chrono::seconds(1));
+    const auto cancelAfterCall = scheduler.Cancel(calledToken);
+
+    // Assert
+    EXPECT_TRUE(firstCancel);
+    EXPECT_FALSE(secondCancel);
+    EXPECT_FALSE(cancelAfterCall);
+}
+
 TEST_F(SchedulerTests, ScheduleWithoutClock) {
     // Arrange
     scheduler = Timekeeping::Scheduler();
+    scheduler.SetClock(nullptr);
     std::promise< void > calledBack;
     const auto callback = [&calledBack]{ calledBack.set_value(); };
     auto calledBackFuture = calledBack.get_future();
@@ -130,10 +336,33 @@ TEST_F(SchedulerTests, ScheduleWithoutClock) {
     );
 
     // Assert
-    EXPECT_EQ(0, token);
+    EXPECT_EQ(0u, token);
     EXPECT_FALSE(wasCalledOnTime);
 }
 
+TEST_F(SchedulerTests, DefaultClockIsSteadyClock) {
+    // Arrange
+    scheduler = Timekeeping::Scheduler();
+    std::promise< void > calledBack;
+    auto calledBackFuture = calledBack.get_future();
+
+    // Act
+    const auto clock = scheduler.GetClock();
+    const auto token = scheduler.ScheduleAfter(
+        [&calledBack]{ calledBack.set_value(); },
+        std::chrono::milliseconds(1)
+    );
+    const auto wasCalled = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_NE(nullptr, std::dynamic_pointer_cast< Timekeeping::SteadyClock >(clock));
+    EXPECT_NE(0u, token);
+    EXPECT_TRUE(wasCalled);
+}
+
 TEST_F(SchedulerTests, GetClock) {
     // Arrange
     scheduler = Timekeeping::Scheduler();
@@ -145,3 +374,1749 @@ TEST_F(SchedulerTests, GetClock) {
     // Assert
     EXPECT_EQ(mockClock, clock);
 }
+
+TEST_F(SchedulerTests, WorkerLeavesCallbacksQueuedWhileClockIsRemoved) {
+    // Arrange
+    std::promise< void > calledBack;
+    const auto callback = [&calledBack]{ calledBack.set_value(); };
+    auto calledBackFuture = calledBack.get_future();
+    (void)scheduler.Schedule(callback, 1.0);
+
+    // Act
+    scheduler.SetClock(nullptr);
+    scheduler.WakeUp();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const auto pendingWithoutClock = scheduler.GetStatistics().pending;
+    scheduler.SetClock(mockClock);
+    AdvanceMockClock(1.0);
+    const auto wasCalled = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_EQ(1u, pendingWithoutClock);
+    EXPECT_TRUE(wasCalled);
+}
+
+TEST_F(SchedulerTests, ScheduleWithTimingWheel) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.backend = Timekeeping::Scheduler::Backend::TimingWheel;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::promise< void > calledBack;
+    const auto callback = [&calledBack]{ calledBack.set_value(); };
+    auto calledBackFuture = calledBack.get_future();
+
+    // Act
+    (void)scheduler.Schedule(callback, 10.0);
+    AdvanceMockClock(5.0);
+    const auto wasCalledEarly = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+    AdvanceMockClock(5.001);
+    const auto wasCalledOnTime = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_FALSE(wasCalledEarly);
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, CancelWithTimingWheel) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.backend = Timekeeping::Scheduler::Backend::TimingWheel;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::promise< void > calledBack;
+    const auto callback = [&calledBack]{ calledBack.set_value(); };
+    auto calledBackFuture = calledBack.get_future();
+    const auto token = scheduler.Schedule(callback, 10.0);
+
+    // Act
+    AdvanceMockClock(5.0);
+    scheduler.Cancel(token);
+    AdvanceMockClock(5.001);
+    const auto wasCalled = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_FALSE(wasCalled);
+}
+
+TEST_F(SchedulerTests, CancelReleasesCallbackImmediately) {
+    // Arrange
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    const auto token = scheduler.Schedule([captured]{}, 1000000.0);
+
+    // Act
+    scheduler.Cancel(token);
+    captured.reset();
+
+    // Assert
+    EXPECT_TRUE(capturedWeak.expired());
+}
+
+TEST_F(SchedulerTests, StaleTokenDoesNotCancelCallbackReusingItsSlot) {
+    // Arrange
+    const auto firstToken = scheduler.Schedule([]{}, 10.0);
+    scheduler.Cancel(firstToken);
+    std::promise< void > calledBack;
+    const auto callback = [&calledBack]{ calledBack.set_value(); };
+    auto calledBackFuture = calledBack.get_future();
+    const auto secondToken = scheduler.Schedule(callback, 10.0);
+
+    // Act
+    scheduler.Cancel(firstToken);
+    AdvanceMockClock(10.001);
+    const auto wasCalledOnTime = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_NE(firstToken, secondToken);
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, ScheduleMoveOnlyCallback) {
+    // Arrange
+    struct MoveOnlyCallback {
+        std::unique_ptr< std::promise< void > > calledBack;
+        void operator()() {
+            calledBack->set_value();
+        }
+    };
+    MoveOnlyCallback callback;
+    callback.calledBack.reset(new std::promise< void >());
+    auto calledBackFuture = callback.calledBack->get_future();
+
+    // Act
+    (void)scheduler.Schedule(std::move(callback), 10.0);
+    AdvanceMockClock(10.001);
+    const auto wasCalledOnTime = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, ScheduleMany) {
+    // Arrange
+    std::mutex calledMutex;
+    std::vector< int > called;
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    std::vector< Timekeeping::Scheduler::ScheduleRequest > requests;
+    for (int i = 0; i < 3; ++i) {
+        requests.push_back(
+            MakeRequest(
+                [i, &calledMutex, &called, &allCalled]{
+                    std::unique_lock< std::mutex > lock(calledMutex);
+                    called.push_back(i);
+                    const auto allWereCalled = (called.size() == 3);
+                    lock.unlock();
+                    if (allWereCalled) {
+                        allCalled.set_value();
+                    }
+                },
+                std::chrono::seconds(3 - i)
+            )
+        );
+    }
+
+    // Act
+    const auto tokens = scheduler.ScheduleMany(std::move(requests));
+    AdvanceMockClock(3.001);
+    const auto wereAllCalled = (
+        allCalledFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    ASSERT_EQ(3, tokens.size());
+    EXPECT_NE(tokens[0], tokens[1]);
+    EXPECT_NE(tokens[1], tokens[2]);
+    EXPECT_NE(0u, tokens[0]);
+    ASSERT_TRUE(wereAllCalled);
+    EXPECT_EQ(std::vector< int >({2, 1, 0}), called);
+}
+
+TEST_F(SchedulerTests, CancelMany) {
+    // Arrange
+    std::promise< void > calledBack;
+    auto calledBackFuture = calledBack.get_future();
+    std::vector< Timekeeping::Scheduler::Token > tokens;
+    bool wrongCallbackCalled = false;
+    for (int i = 0; i < 3; ++i) {
+        tokens.push_back(
+            scheduler.Schedule(
+                [&wrongCallbackCalled]{ wrongCallbackCalled = true; },
+                1.0 + i
+            )
+        );
+    }
+    (void)scheduler.Schedule([&calledBack]{ calledBack.set_value(); }, 5.0);
+
+    // Act
+    scheduler.CancelMany(tokens);
+    AdvanceMockClock(5.001);
+    const auto wasCalledOnTime = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_TRUE(wasCalledOnTime);
+    EXPECT_FALSE(wrongCallbackCalled);
+}
+
+TEST_F(SchedulerTests, BatchedCallbacksAreCalledInDueOrderWithOneClockReading) {
+    // Arrange
+    struct CountingClock
+        : public Timekeeping::Clock
+    {
+        std::atomic< double > currentTime{0.0};
+        std::atomic< int > readings{0};
+
+        virtual double GetCurrentTime() override {
+            ++readings;
+            return currentTime;
+        }
+    };
+    const auto countingClock = std::make_shared< CountingClock >();
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.maxBatchSize = 100;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(countingClock);
+    std::vector< int > called;
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    std::vector< Timekeeping::Scheduler::ScheduleRequest > requests;
+    for (int i = 0; i < 50; ++i) {
+        requests.push_back(
+            MakeRequest(
+                [i, &called, &allCalled]{
+                    called.push_back(i);
+                    if (called.size() == 50) {
+                        allCalled.set_value();
+                    }
+                },
+                std::chrono::milliseconds(1000 + 10 * i)
+            )
+        );
+    }
+    (void)scheduler.ScheduleMany(std::move(requests));
+    const auto readingsBefore = countingClock->readings.load();
+
+    // Act
+    countingClock->currentTime = 2.0;
+    scheduler.WakeUp();
+    const auto wereAllCalled = (
+        allCalledFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+
+    // Assert
+    ASSERT_TRUE(wereAllCalled);
+    std::vector< int > expected;
+    for (int i = 0; i < 50; ++i) {
+        expected.push_back(i);
+    }
+    EXPECT_EQ(expected, called);
+    EXPECT_LE(countingClock->readings.load() - readingsBefore, 2);
+}
+
+TEST_F(SchedulerTests, SlowCallbackDoesNotDelayOthersWithCallbackThreads) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.callbackThreads = 2;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::promise< void > releaseSlowCallback;
+    auto releaseSlowCallbackFuture = releaseSlowCallback.get_future().share();
+    std::promise< void > calledBack;
+    auto calledBackFuture = calledBack.get_future();
+    (void)scheduler.Schedule(
+        [releaseSlowCallbackFuture]{ releaseSlowCallbackFuture.wait(); },
+        1.0
+    );
+    (void)scheduler.Schedule([&calledBack]{ calledBack.set_value(); }, 2.0);
+
+    // Act
+    AdvanceMockClock(2.001);
+    const auto wasCalledOnTime = (
+        calledBackFuture.wait_for(std::chrono::milliseconds(100))
+        == std::future_status::ready
+    );
+    releaseSlowCallback.set_value();
+
+    // Assert
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, CallbacksAreHandedToExecutor) {
+    // Arrange
+    const auto executor = std::make_shared< MockExecutor >();
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.executor = executor;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    bool called = false;
+    Timekeeping::Scheduler::ScheduleRequest request;
+    request.callback = [&called]{ called = true; };
+    request.due = std::chrono::seconds(1);
+    request.strand = 7;
+    (void)scheduler.Schedule(std::move(request));
+
+    // Act
+    AdvanceMockClock(1.001);
+    const auto executorGotTask = executor->AwaitTasks(1);
+
+    // Assert
+    ASSERT_TRUE(executorGotTask);
+    EXPECT_FALSE(called);
+    std::lock_guard< decltype(executor->mutex) > lock(executor->mutex);
+    EXPECT_EQ(7, executor->tasks[0].second);
+    executor->tasks[0].first();
+    EXPECT_TRUE(called);
+}
+
+TEST_F(SchedulerTests, ShardedSchedulerMergesShardsInDueOrder) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.shards = 4;
+    configuration.maxBatchSize = 100;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::mutex calledMutex;
+    std::vector< int > called;
+    std::vector< Timekeeping::Scheduler::Token > tokensToCancel;
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([
+            this, t, &calledMutex, &called, &tokensToCancel
+        ]{
+            for (int k = 0; k < 10; ++k) {
+                const auto i = k * 4 + t;
+                const auto token = scheduler.Schedule(
+                    [i, &calledMutex, &called]{
+                        std::lock_guard< std::mutex > lock(calledMutex);
+                        called.push_back(i);
+                    },
+                    std::chrono::milliseconds(1000 + 10 * i)
+                );
+                if (i % 5 == 0) {
+                    std::lock_guard< std::mutex > lock(calledMutex);
+                    tokensToCancel.push_back(token);
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    (void)scheduler.Schedule([&allCalled]{ allCalled.set_value(); }, 2.0);
+
+    // Act
+    scheduler.CancelMany(tokensToCancel);
+    AdvanceMockClock(2.001);
+    const auto wereAllCalled = (
+        allCalledFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    ASSERT_TRUE(wereAllCalled);
+    std::vector< int > expected;
+    for (int i = 0; i < 40; ++i) {
+        if (i % 5 != 0) {
+            expected.push_back(i);
+        }
+    }
+    EXPECT_EQ(expected, called);
+}
+
+TEST_F(SchedulerTests, LockFreeSubmissionFromManyThreads) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    configuration.maxBatchSize = 100;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::mutex calledMutex;
+    std::vector< int > called;
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([this, t, &calledMutex, &called]{
+            for (int k = 0; k < 50; ++k) {
+                const auto i = k * 4 + t;
+                const auto token = scheduler.Schedule(
+                    [i, &calledMutex, &called]{
+                        std::lock_guard< std::mutex > lock(calledMutex);
+                        called.push_back(i);
+                    },
+                    1.0 + 0.001 * i
+                );
+                if (i % 5 == 0) {
+                    scheduler.Cancel(token);
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    (void)scheduler.Schedule([&allCalled]{ allCalled.set_value(); }, 2.0);
+
+    // Act
+    AdvanceMockClock(2.001);
+    const auto wereAllCalled = (
+        allCalledFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    ASSERT_TRUE(wereAllCalled);
+    std::vector< int > expected;
+    for (int i = 0; i < 200; ++i) {
+        if (i % 5 != 0) {
+            expected.push_back(i);
+        }
+    }
+    EXPECT_EQ(expected, called);
+}
+
+TEST_F(SchedulerTests, LockFreeSubmissionCancelReleasesPeriodicCallbackOnWorkerThread) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    const auto token = scheduler.SchedulePeriodic([captured]{}, 1000000.0, 1.0);
+    captured.reset();
+
+    // Act
+    scheduler.Cancel(token);
+    for (int i = 0; i < 1000; ++i) {
+        if (capturedWeak.expired()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Assert
+    EXPECT_TRUE(capturedWeak.expired());
+}
+
+TEST_F(SchedulerTests, LockFreeSubmissionCancelReleasesCallbackWithoutShardLocked) {
+    // Arrange
+    struct OnDestroyed {
+        std::function< void() > action;
+        ~OnDestroyed() {
+            action();
+        }
+    };
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    configuration.threadless = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto otherToken = scheduler.Schedule([]{}, 10.0);
+    auto otherThreadCouldUseShard = false;
+    auto onDestroyed = std::make_shared< OnDestroyed >();
+    onDestroyed->action = [this, otherToken, &otherThreadCouldUseShard]{
+        auto rescheduled = std::async(
+            std::launch::async,
+            [this, otherToken]{ return scheduler.Reschedule(otherToken, 20.0); }
+        );
+        otherThreadCouldUseShard = (
+            rescheduled.wait_for(std::chrono::milliseconds(1000))
+            == std::future_status::ready
+        );
+    };
+    const auto token = scheduler.SchedulePeriodic([onDestroyed]{}, 1.0, 1.0);
+    std::weak_ptr< OnDestroyed > onDestroyedWeak(onDestroyed);
+    onDestroyed.reset();
+
+    // Act
+    (void)scheduler.Cancel(token);
+    (void)scheduler.GetNextDeadline();
+
+    // Assert
+    EXPECT_TRUE(onDestroyedWeak.expired());
+    EXPECT_TRUE(otherThreadCouldUseShard);
+}
+
+TEST_F(SchedulerTests, LockFreeSubmissionCancelDestroysCallbackBeforeReturning) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    const auto token = scheduler.Schedule([captured]{}, 1000000.0);
+    captured.reset();
+
+    // Act
+    const auto canceled = scheduler.Cancel(token);
+
+    // Assert
+    EXPECT_TRUE(canceled);
+    EXPECT_TRUE(capturedWeak.expired());
+}
+
+TEST_F(SchedulerTests, ScheduleAfterNextDueDoesNotWakeWorker) {
+    // Arrange
+    std::promise< void > earliestCalled;
+    auto earliestCalledFuture = earliestCalled.get_future();
+    (void)scheduler.Schedule([&earliestCalled]{ earliestCalled.set_value(); }, 10.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto statisticsBefore = scheduler.GetStatistics();
+
+    // Act
+    for (int i = 0; i < 100; ++i) {
+        (void)scheduler.Schedule([]{}, 20.0 + i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto statisticsAfterLaterCallbacks = scheduler.GetStatistics();
+    AdvanceMockClock(10.001);
+    const auto wasEarliestCalled = (
+        earliestCalledFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_EQ(statisticsBefore.wakeUps, statisticsAfterLaterCallbacks.wakeUps);
+    ASSERT_TRUE(wasEarliestCalled);
+    EXPECT_GE(scheduler.GetStatistics().usefulWakeUps, 1u);
+}
+
+TEST_F(SchedulerTests, PreciseWaitingCallsSubMillisecondTimersOnTime) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.preciseWaiting = true;
+    configuration.spinTime = 0.0002;
+    scheduler = Timekeeping::Scheduler(configuration);
+    const auto steadyClock = std::make_shared< SteadyTestClock >();
+    scheduler.SetClock(steadyClock);
+    std::vector< double > lateness;
+
+    // Act
+    for (int i = 0; i < 20; ++i) {
+        std::promise< double > called;
+        auto calledFuture = called.get_future();
+        const auto due = steadyClock->GetCurrentTime() + 0.0003;
+        (void)scheduler.Schedule(
+            [&called, steadyClock]{ called.set_value(steadyClock->GetCurrentTime()); },
+            due
+        );
+        ASSERT_EQ(
+            std::future_status::ready,
+            calledFuture.wait_for(std::chrono::milliseconds(1000))
+        );
+        lateness.push_back(calledFuture.get() - due);
+    }
+
+    // Assert
+    std::sort(lateness.begin(), lateness.end());
+    EXPECT_GE(lateness.front(), 0.0);
+    EXPECT_LT(lateness[lateness.size() / 2], 0.0005);
+}
+
+TEST_F(SchedulerTests, ScheduleWithChronoTypesOnTickClock) {
+    // Arrange
+    struct MockTickClock
+        : public Timekeeping::TickClock
+    {
+        std::atomic< int64_t > currentTicks{1546300800000000000};
+
+        virtual int64_t GetCurrentTicks() override {
+            return currentTicks;
+        }
+    };
+    const auto tickClock = std::make_shared< MockTickClock >();
+    scheduler.SetClock(tickClock);
+    std::mutex calledMutex;
+    std::vector< int > called;
+    const auto epoch = std::chrono::time_point< std::chrono::system_clock, std::chrono::nanoseconds >(
+        std::chrono::nanoseconds(tickClock->currentTicks)
+    );
+    (void)scheduler.Schedule(
+        [&calledMutex, &called]{
+            std::lock_guard< std::mutex > lock(calledMutex);
+            called.push_back(1);
+        },
+        epoch + std::chrono::nanoseconds(1001)
+    );
+    (void)scheduler.ScheduleAfter(
+        [&calledMutex, &called]{
+            std::lock_guard< std::mutex > lock(calledMutex);
+            called.push_back(2);
+        },
+        std::chrono::microseconds(2)
+    );
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    (void)scheduler.ScheduleAfter(
+        [&allCalled]{ allCalled.set_value(); },
+        std::chrono::microseconds(3)
+    );
+
+    // Act
+    tickClock->currentTicks += 1000;
+    scheduler.WakeUp();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::unique_lock< std::mutex > lock(calledMutex);
+    const auto calledBeforeDue = called;
+    lock.unlock();
+    tickClock->currentTicks += 2000;
+    scheduler.WakeUp();
+    const auto wereAllCalled = (
+        allCalledFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_EQ(std::vector< int >(), calledBeforeDue);
+    ASSERT_TRUE(wereAllCalled);
+    EXPECT_EQ(std::vector< int >({1, 2}), called);
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicFixedRate) {
+    // Arrange
+    CallCounter counter;
+
+    // Act
+    const auto token = scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0
+    );
+    AdvanceMockClock(0.5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsBeforeFirstDue = counter.GetCalls();
+    AdvanceMockClock(0.501);
+    const auto wasCalledOnce = counter.AwaitCalls(1);
+    AdvanceMockClock(1.0);
+    const auto wasCalledTwice = counter.AwaitCalls(2);
+    AdvanceMockClock(1.0);
+    const auto wasCalledThrice = counter.AwaitCalls(3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_NE(0u, token);
+    EXPECT_EQ(0u, callsBeforeFirstDue);
+    EXPECT_TRUE(wasCalledOnce);
+    EXPECT_TRUE(wasCalledTwice);
+    EXPECT_TRUE(wasCalledThrice);
+    EXPECT_EQ(3u, counter.GetCalls());
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicRejectsNonPositiveInterval) {
+    // Arrange
+
+    // Act
+    const auto token = scheduler.SchedulePeriodic([]{}, 1.0, 0.0);
+
+    // Assert
+    EXPECT_EQ(0u, token);
+}
+
+TEST_F(SchedulerTests, CancelPeriodic) {
+    // Arrange
+    CallCounter counter;
+    const auto token = scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0
+    );
+    AdvanceMockClock(1.001);
+    ASSERT_TRUE(counter.AwaitCalls(1));
+
+    // Act
+    scheduler.Cancel(token);
+    AdvanceMockClock(1.0);
+    AdvanceMockClock(1.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_EQ(1u, counter.GetCalls());
+}
+
+TEST_F(SchedulerTests, CancelPeriodicFromItsOwnCallback) {
+    // Arrange
+    CallCounter counter;
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    std::promise< Timekeeping::Scheduler::Token > tokenPromise;
+    auto tokenFuture = tokenPromise.get_future().share();
+    auto& schedulerRef = scheduler;
+    tokenPromise.set_value(
+        scheduler.SchedulePeriodic(
+            [&counter, &schedulerRef, tokenFuture, captured]{
+                counter.Call();
+                schedulerRef.Cancel(tokenFuture.get());
+            },
+            1.0,
+            1.0
+        )
+    );
+    captured.reset();
+
+    // Act
+    AdvanceMockClock(1.001);
+    ASSERT_TRUE(counter.AwaitCalls(1));
+    AdvanceMockClock(1.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_EQ(1u, counter.GetCalls());
+    EXPECT_TRUE(capturedWeak.expired());
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicSkipsMissedPeriods) {
+    // Arrange
+    CallCounter counter;
+    (void)scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0,
+        Timekeeping::Scheduler::PeriodicMode::FixedRate,
+        Timekeeping::Scheduler::CatchUp::SkipMissedPeriods
+    );
+
+    // Act
+    AdvanceMockClock(4.001);
+    ASSERT_TRUE(counter.AwaitCalls(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsAfterMissedPeriods = counter.GetCalls();
+    AdvanceMockClock(0.5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsBeforeNextPeriod = counter.GetCalls();
+    AdvanceMockClock(0.5);
+    const auto wasCalledOnNextPeriod = counter.AwaitCalls(3);
+
+    // Assert
+    EXPECT_EQ(2u, callsAfterMissedPeriods);
+    EXPECT_EQ(2u, callsBeforeNextPeriod);
+    EXPECT_TRUE(wasCalledOnNextPeriod);
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicCallsForEachMissedPeriod) {
+    // Arrange
+    CallCounter counter;
+    (void)scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0,
+        Timekeeping::Scheduler::PeriodicMode::FixedRate,
+        Timekeeping::Scheduler::CatchUp::CallForEachPeriod
+    );
+
+    // Act
+    AdvanceMockClock(4.001);
+    const auto wasCalledForEachPeriod = counter.AwaitCalls(4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_TRUE(wasCalledForEachPeriod);
+    EXPECT_EQ(4u, counter.GetCalls());
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicFixedDelay) {
+    // Arrange
+    CallCounter counter;
+    (void)scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0,
+        Timekeeping::Scheduler::PeriodicMode::FixedDelay
+    );
+
+    // Act
+    AdvanceMockClock(1.5);
+    ASSERT_TRUE(counter.AwaitCalls(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    AdvanceMockClock(0.75);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsBeforeDelayElapsed = counter.GetCalls();
+    AdvanceMockClock(0.251);
+    const auto wasCalledAfterDelay = counter.AwaitCalls(2);
+
+    // Assert
+    EXPECT_EQ(1u, callsBeforeDelayElapsed);
+    EXPECT_TRUE(wasCalledAfterDelay);
+}
+
+TEST_F(SchedulerTests, SchedulePeriodicWithLockFreeSubmission) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    CallCounter counter;
+    const auto token = scheduler.SchedulePeriodic(
+        [&counter]{ counter.Call(); },
+        1.0,
+        1.0
+    );
+
+    // Act
+    AdvanceMockClock(1.001);
+    const auto wasCalledOnce = counter.AwaitCalls(1);
+    AdvanceMockClock(1.0);
+    const auto wasCalledTwice = counter.AwaitCalls(2);
+    scheduler.Cancel(token);
+    AdvanceMockClock(1.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_TRUE(wasCalledOnce);
+    EXPECT_TRUE(wasCalledTwice);
+    EXPECT_EQ(2u, counter.GetCalls());
+}
+
+TEST_F(SchedulerTests, RescheduleLater) {
+    // Arrange
+    CallCounter counter;
+    const auto token = scheduler.Schedule([&counter]{ counter.Call(); }, 1.0);
+
+    // Act
+    const auto wasRescheduled = scheduler.Reschedule(token, 2.0);
+    AdvanceMockClock(1.001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsAtOldDue = counter.GetCalls();
+    const auto wasRescheduledAgain = scheduler.Reschedule(token, 3.0);
+    AdvanceMockClock(1.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsAtFirstNewDue = counter.GetCalls();
+    AdvanceMockClock(1.0);
+    const auto wasCalledOnTime = counter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_TRUE(wasRescheduled);
+    EXPECT_TRUE(wasRescheduledAgain);
+    EXPECT_EQ(0u, callsAtOldDue);
+    EXPECT_EQ(0u, callsAtFirstNewDue);
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, RescheduleEarlier) {
+    // Arrange
+    CallCounter counter;
+    const auto token = scheduler.Schedule([&counter]{ counter.Call(); }, 10.0);
+
+    // Act
+    const auto wasRescheduled = scheduler.Reschedule(token, 1.0);
+    AdvanceMockClock(1.001);
+    const auto wasCalledOnTime = counter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_TRUE(wasRescheduled);
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, RescheduleAfterCallOrCancelFails) {
+    // Arrange
+    CallCounter counter;
+    const auto calledToken = scheduler.Schedule([&counter]{ counter.Call(); }, 1.0);
+    const auto canceledToken = scheduler.Schedule([]{}, 1.0);
+    scheduler.Cancel(canceledToken);
+    AdvanceMockClock(1.001);
+    ASSERT_TRUE(counter.AwaitCalls(1));
+
+    // Act
+    const auto wasCalledRescheduled = scheduler.Reschedule(calledToken, 5.0);
+    const auto wasCanceledRescheduled = scheduler.Reschedule(canceledToken, 5.0);
+
+    // Assert
+    EXPECT_FALSE(wasCalledRescheduled);
+    EXPECT_FALSE(wasCanceledRescheduled);
+}
+
+TEST_F(SchedulerTests, RescheduleAfterDelay) {
+    // Arrange
+    CallCounter counter;
+    const auto token = scheduler.Schedule([&counter]{ counter.Call(); }, 1.0);
+
+    // Act
+    AdvanceMockClock(0.5);
+    const auto wasRescheduled = scheduler.RescheduleAfter(
+        token,
+        std::chrono::seconds(1)
+    );
+    AdvanceMockClock(0.501);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsAtOldDue = counter.GetCalls();
+    AdvanceMockClock(0.5);
+    const auto wasCalledOnTime = counter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_TRUE(wasRescheduled);
+    EXPECT_EQ(0u, callsAtOldDue);
+    EXPECT_TRUE(wasCalledOnTime);
+}
+
+TEST_F(SchedulerTests, RescheduleWithLockFreeSubmission) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    CallCounter laterCounter;
+    CallCounter earlierCounter;
+    const auto laterToken = scheduler.Schedule([&laterCounter]{ laterCounter.Call(); }, 1.0);
+    const auto earlierToken = scheduler.Schedule([&earlierCounter]{ earlierCounter.Call(); }, 10.0);
+
+    // Act
+    const auto wasLaterRescheduled = scheduler.Reschedule(laterToken, 2.0);
+    const auto wasEarlierRescheduled = scheduler.Reschedule(earlierToken, 1.0);
+    AdvanceMockClock(1.001);
+    const auto wasEarlierCalledOnTime = earlierCounter.AwaitCalls(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto laterCallsAtOldDue = laterCounter.GetCalls();
+    AdvanceMockClock(1.0);
+    const auto wasLaterCalledOnTime = laterCounter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_TRUE(wasLaterRescheduled);
+    EXPECT_TRUE(wasEarlierRescheduled);
+    EXPECT_TRUE(wasEarlierCalledOnTime);
+    EXPECT_EQ(0u, laterCallsAtOldDue);
+    EXPECT_TRUE(wasLaterCalledOnTime);
+}
+
+TEST_F(SchedulerTests, SlackGroupsNearbyCallbacksTogether) {
+    // Arrange
+    CallCounter relaxedCounter;
+    CallCounter strictCounter;
+    for (int i = 0; i < 10; ++i) {
+        (void)scheduler.Schedule(
+            [&relaxedCounter]{ relaxedCounter.Call(); },
+            1.0 + 0.0005 * i,
+            0.02
+        );
+    }
+    (void)scheduler.Schedule([&strictCounter]{ strictCounter.Call(); }, 1.001);
+
+    // Act
+    AdvanceMockClock(1.005);
+    const auto wasStrictCalledOnTime = strictCounter.AwaitCalls(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto relaxedCallsAtDue = relaxedCounter.GetCalls();
+    AdvanceMockClock(0.015);
+    const auto wereRelaxedCalledWithinSlack = relaxedCounter.AwaitCalls(10);
+
+    // Assert
+    EXPECT_TRUE(wasStrictCalledOnTime);
+    EXPECT_EQ(0u, relaxedCallsAtDue);
+    EXPECT_TRUE(wereRelaxedCalledWithinSlack);
+}
+
+TEST_F(SchedulerTests, SlackAppliesToRescheduledCallbacks) {
+    // Arrange
+    CallCounter counter;
+    const auto token = scheduler.Schedule(
+        [&counter]{ counter.Call(); },
+        std::chrono::seconds(1),
+        std::chrono::milliseconds(20)
+    );
+
+    // Act
+    (void)scheduler.Reschedule(token, 2.0);
+    AdvanceMockClock(2.001);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const auto callsAtDue = counter.GetCalls();
+    AdvanceMockClock(0.019);
+    const auto wasCalledWithinSlack = counter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_EQ(0u, callsAtDue);
+    EXPECT_TRUE(wasCalledWithinSlack);
+}
+
+TEST_F(SchedulerTests, ThreadlessModeRunsDueCallbacksWhenAsked) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::vector< int > called;
+    (void)scheduler.Schedule([&called]{ called.push_back(1); }, 1.0);
+    (void)scheduler.Schedule([&called]{ called.push_back(2); }, 2.0);
+
+    // Act
+    const auto firstDeadline = scheduler.GetNextDeadline();
+    const auto calledEarly = scheduler.RunDue(std::chrono::milliseconds(500));
+    const auto calledAtFirstDeadline = scheduler.RunDue(firstDeadline);
+    const auto secondDeadline = scheduler.GetNextDeadline();
+    mockClock->currentTime = 2.001;
+    const auto calledAtSecondDeadline = scheduler.RunDue();
+    const auto finalDeadline = scheduler.GetNextDeadline();
+
+    // Assert
+    EXPECT_EQ(std::chrono::nanoseconds(std::chrono::seconds(1)), firstDeadline);
+    EXPECT_EQ(0u, calledEarly);
+    EXPECT_EQ(1u, calledAtFirstDeadline);
+    EXPECT_EQ(std::chrono::nanoseconds(std::chrono::seconds(2)), secondDeadline);
+    EXPECT_EQ(1u, calledAtSecondDeadline);
+    EXPECT_EQ(std::chrono::nanoseconds::max(), finalDeadline);
+    EXPECT_EQ(std::vector< int >({1, 2}), called);
+}
+
+TEST_F(SchedulerTests, ThreadlessModeReportsSoonerDeadlines) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    std::atomic< size_t > deadlineChanges{0};
+    configuration.deadlineChanged = [&deadlineChanges]{ ++deadlineChanges; };
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    (void)scheduler.Schedule([]{}, 2.0);
+    (void)scheduler.GetNextDeadline();
+    deadlineChanges = 0;
+
+    // Act
+    (void)scheduler.Schedule([]{}, 3.0);
+    const auto changesAfterLaterCallback = deadlineChanges.load();
+    (void)scheduler.Schedule([]{}, 1.5);
+    (void)scheduler.Schedule([]{}, 1.2);
+    const auto changesAfterSoonerCallbacks = deadlineChanges.load();
+    const auto nextDeadline = scheduler.GetNextDeadline();
+
+    // Assert
+    EXPECT_EQ(0u, changesAfterLaterCallback);
+    EXPECT_EQ(1u, changesAfterSoonerCallbacks);
+    EXPECT_EQ(std::chrono::nanoseconds(std::chrono::milliseconds(1200)), nextDeadline);
+}
+
+#if defined(__linux__)
+TEST_F(SchedulerTests, ThreadlessPollDescriptorBecomesReadableWhenNeeded) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.pollable = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto descriptor = scheduler.GetPollDescriptor();
+    ASSERT_GE(descriptor, 0);
+    const auto isReadable = [descriptor](int timeout){
+        struct pollfd pollDescriptor = {};
+        pollDescriptor.fd = descriptor;
+        pollDescriptor.events = POLLIN;
+        return (poll(&pollDescriptor, 1, timeout) == 1);
+    };
+    (void)scheduler.Schedule([]{}, 0.05);
+
+    // Act
+    (void)scheduler.GetNextDeadline();
+    const auto wasReadableEarly = isReadable(0);
+    const auto wasReadableOnTime = isReadable(1000);
+    (void)scheduler.GetNextDeadline();
+    const auto wasReadableAfterRearming = isReadable(0);
+    scheduler.RunDue(std::chrono::milliseconds(50));
+    (void)scheduler.GetNextDeadline();
+    std::thread scheduling([this]{ (void)scheduler.Schedule([]{}, 1.0); });
+    const auto wasReadableAfterScheduling = isReadable(1000);
+    scheduling.join();
+
+    // Assert
+    EXPECT_FALSE(wasReadableEarly);
+    EXPECT_TRUE(wasReadableOnTime);
+    EXPECT_FALSE(wasReadableAfterRearming);
+    EXPECT_TRUE(wasReadableAfterScheduling);
+}
+#endif
+
+TEST_F(SchedulerTests, StatisticsCountPendingCanceledAndFiredCallbacks) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.measureCallbackTime = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    (void)scheduler.Schedule(
+        []{ std::this_thread::sleep_for(std::chrono::milliseconds(1)); },
+        1.0
+    );
+    (void)scheduler.Schedule([]{}, 2.0);
+    const auto token = scheduler.Schedule([]{}, 3.0);
+    scheduler.Cancel(token);
+
+    // Act
+    const auto statisticsBefore = scheduler.GetStatistics();
+    mockClock->currentTime = 1.5;
+    (void)scheduler.RunDue();
+    const auto statisticsAfter = scheduler.GetStatistics();
+
+    // Assert
+    EXPECT_EQ(2u, statisticsBefore.pending);
+    EXPECT_EQ(0u, statisticsBefore.canceledUnreclaimed);
+    EXPECT_EQ(0u, statisticsBefore.fired);
+    EXPECT_EQ(1u, statisticsAfter.pending);
+    EXPECT_EQ(1u, statisticsAfter.fired);
+    EXPECT_EQ(std::chrono::milliseconds(500), statisticsAfter.medianLateness);
+    EXPECT_EQ(std::chrono::milliseconds(500), statisticsAfter.lateness99th);
+    EXPECT_EQ(std::chrono::milliseconds(500), statisticsAfter.maxLateness);
+    EXPECT_GE(statisticsAfter.maxCallbackTime, std::chrono::milliseconds(1));
+}
+
+TEST_F(SchedulerTests, StatisticsCountCancellationsNotYetReclaimed) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto token = scheduler.Schedule([]{}, 1.0);
+    (void)scheduler.GetNextDeadline();
+
+    // Act
+    scheduler.Cancel(token);
+    const auto statisticsBeforeReclaiming = scheduler.GetStatistics();
+    (void)scheduler.GetNextDeadline();
+    const auto statisticsAfterReclaiming = scheduler.GetStatistics();
+
+    // Assert
+    EXPECT_EQ(0u, statisticsBeforeReclaiming.pending);
+    EXPECT_EQ(1u, statisticsBeforeReclaiming.canceledUnreclaimed);
+    EXPECT_EQ(0u, statisticsAfterReclaiming.canceledUnreclaimed);
+}
+
+TEST_F(SchedulerTests, SlowCallbacksAreReportedWithTokenAndSite) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.slowCallbackThreshold = 0.01;
+    std::vector< Timekeeping::Scheduler::Token > slowTokens;
+    std::vector< std::string > slowSites;
+    std::vector< std::chrono::nanoseconds > slowDurations;
+    configuration.slowCallback = [&](
+        Timekeeping::Scheduler::Token token,
+        const char* site,
+        std::chrono::nanoseconds duration
+    ) {
+        slowTokens.push_back(token);
+        slowSites.push_back(site);
+        slowDurations.push_back(duration);
+    };
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    Timekeeping::Scheduler::ScheduleRequest fastRequest;
+    fastRequest.callback = []{};
+    fastRequest.due = std::chrono::seconds(1);
+    fastRequest.site = "fast";
+    (void)scheduler.Schedule(std::move(fastRequest));
+    Timekeeping::Scheduler::ScheduleRequest slowRequest;
+    slowRequest.callback = []{
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    };
+    slowRequest.due = std::chrono::seconds(2);
+    slowRequest.site = "slow";
+    const auto slowToken = scheduler.Schedule(std::move(slowRequest));
+
+    // Act
+    mockClock->currentTime = 3.0;
+    while (scheduler.RunDue() > 0) {
+    }
+
+    // Assert
+    EXPECT_EQ(std::vector< Timekeeping::Scheduler::Token >({slowToken}), slowTokens);
+    EXPECT_EQ(std::vector< std::string >({"slow"}), slowSites);
+    ASSERT_EQ(1u, slowDurations.size());
+    EXPECT_GE(slowDurations[0], std::chrono::milliseconds(20));
+}
+
+TEST_F(SchedulerTests, WatchdogReportsCallbackWhichStallsWorker) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.watchdogTimeout = 0.02;
+    std::promise< void > stallReported;
+    std::atomic< Timekeeping::Scheduler::Token > stalledToken{0};
+    std::atomic< const char* > stalledSite{nullptr};
+    std::atomic< size_t > stalls{0};
+    configuration.workerStalled = [&](
+        Timekeeping::Scheduler::Token token,
+        const char* site,
+        std::chrono::nanoseconds
+    ) {
+        stalledToken = token;
+        stalledSite = site;
+        if (++stalls == 1) {
+            stallReported.set_value();
+        }
+    };
+    scheduler = Timekeeping::Scheduler(configuration);
+    auto stallReportedFuture = stallReported.get_future();
+    Timekeeping::Scheduler::ScheduleRequest request;
+    request.callback = [&stallReportedFuture]{
+        (void)stallReportedFuture.wait_for(std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    };
+    request.site = "stuck";
+
+    // Act
+    const auto token = scheduler.Schedule(std::move(request));
+    CallCounter counter;
+    (void)scheduler.Schedule([&counter]{ counter.Call(); }, std::chrono::nanoseconds(0));
+    const auto called = counter.AwaitCalls(1);
+
+    // Assert
+    EXPECT_TRUE(called);
+    EXPECT_EQ(1u, stalls);
+    EXPECT_EQ(token, stalledToken);
+    EXPECT_STREQ("stuck", stalledSite);
+}
+
+#if defined(TIMEKEEPING_TRACING)
+TEST_F(SchedulerTests, TracerIsToldAboutCallbackLifecycle) {
+    // Arrange
+    struct MockTracer
+        : public Timekeeping::Tracer
+    {
+        // Properties
+
+        std::vector< std::string > events;
+
+        // Methods
+
+        // Timekeeping::Tracer
+
+        virtual void Scheduled(
+            uint64_t token,
+            int64_t due
+        ) override {
+            events.push_back(
+                "Scheduled " + std::to_string(token) + " " + std::to_string(due)
+            );
+        }
+
+        virtual void Canceled(uint64_t token) override {
+            events.push_back("Canceled " + std::to_string(token));
+        }
+
+        virtual void CallbackStarting(
+            uint64_t token,
+            int64_t due
+        ) override {
+            events.push_back(
+                "CallbackStarting " + std::to_string(token) + " " + std::to_string(due)
+            );
+        }
+
+        virtual void CallbackFinished(uint64_t token) override {
+            events.push_back("CallbackFinished " + std::to_string(token));
+        }
+    };
+    const auto tracer = std::make_shared< MockTracer >();
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.tracer = tracer;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+
+    // Act
+    const auto calledToken = scheduler.Schedule([]{}, 1.0);
+    const auto canceledToken = scheduler.Schedule([]{}, 2.0);
+    scheduler.Cancel(canceledToken);
+    scheduler.Cancel(canceledToken);
+    (void)scheduler.RunDue(std::chrono::seconds(3));
+
+    // Assert
+    EXPECT_EQ(
+        std::vector< std::string >({
+            "Scheduled " + std::to_string(calledToken) + " 1000000000",
+            "Scheduled " + std::to_string(canceledToken) + " 2000000000",
+            "Canceled " + std::to_string(canceledToken),
+            "CallbackStarting " + std::to_string(calledToken) + " 1000000000",
+            "CallbackFinished " + std::to_string(calledToken),
+        }),
+        tracer->events
+    );
+}
+#endif
+
+TEST_F(SchedulerTests, ReservedRoomIsUsedForCallbacks) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.maxBatchSize = 1000;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    scheduler.Reserve(1000);
+    size_t calls = 0;
+    const auto allocationsBefore = allocations.load();
+    for (size_t i = 0; i < 1000; ++i) {
+        (void)scheduler.Schedule([&calls]{ ++calls; }, 1.0);
+    }
+    const auto allocationsScheduling = allocations.load() - allocationsBefore;
+
+    // Act
+    const auto called = scheduler.RunDue(std::chrono::seconds(1));
+
+    // Assert
+    EXPECT_EQ(0u, allocationsScheduling);
+    EXPECT_EQ(1000u, called);
+    EXPECT_EQ(1000u, calls);
+}
+
+TEST_F(SchedulerTests, ShrinkToFitAfterBurstKeepsStaleTokensStale) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.maxBatchSize = 10000;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto keptToken = scheduler.Schedule([]{}, 5.0);
+    std::vector< Timekeeping::Scheduler::Token > burstTokens;
+    for (size_t i = 0; i < 10000; ++i) {
+        burstTokens.push_back(scheduler.Schedule([]{}, 1.0));
+    }
+    (void)scheduler.RunDue(std::chrono::seconds(1));
+
+    // Act
+    scheduler.ShrinkToFit();
+    std::vector< Timekeeping::Scheduler::Token > newTokens;
+    size_t calls = 0;
+    for (size_t i = 0; i < 10000; ++i) {
+        newTokens.push_back(scheduler.Schedule([&calls]{ ++calls; }, 2.0));
+    }
+    scheduler.CancelMany(burstTokens);
+    for (const auto token: burstTokens) {
+        EXPECT_FALSE(scheduler.Reschedule(token, 3.0));
+    }
+    const auto called = scheduler.RunDue(std::chrono::seconds(2));
+
+    // Assert
+    EXPECT_EQ(10000u, called);
+    EXPECT_EQ(10000u, calls);
+    EXPECT_TRUE(scheduler.Reschedule(keptToken, 6.0));
+    EXPECT_EQ(0u, scheduler.GetStatistics().canceledUnreclaimed);
+}
+
+TEST_F(SchedulerTests, CallbacksDueAtTheSameTimeAreCalledInOrderScheduled) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.maxBatchSize = 100;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::vector< size_t > called;
+    std::vector< size_t > expected;
+    for (size_t i = 0; i < 100; ++i) {
+        (void)scheduler.Schedule([&called, i]{ called.push_back(i); }, 1.0);
+        expected.push_back(i);
+    }
+
+    // Act
+    (void)scheduler.RunDue(std::chrono::seconds(1));
+
+    // Assert
+    EXPECT_EQ(expected, called);
+}
+
+TEST_F(SchedulerTests, SchedulerCanBeDestroyedByItsOwnCallback) {
+    // Arrange
+    auto owned = std::unique_ptr< Timekeeping::Scheduler >(
+        new Timekeeping::Scheduler()
+    );
+    owned->SetClock(mockClock);
+    std::promise< void > destroyed;
+    auto destroyedFuture = destroyed.get_future();
+    (void)owned->Schedule(
+        [&owned, &destroyed]{
+            owned.reset();
+            destroyed.set_value();
+        },
+        1.0
+    );
+    (void)owned->Schedule([]{}, 1.0);
+    mockClock->currentTime = 1.001;
+
+    // Act
+    owned->WakeUp();
+    const auto wasDestroyed = (
+        destroyedFuture.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    EXPECT_TRUE(wasDestroyed);
+}
+
+TEST_F(SchedulerTests, ShutdownDroppingAllCallsNoCallbacks) {
+    // Arrange
+    std::atomic< size_t > calls{0};
+    (void)scheduler.Schedule([&calls]{ ++calls; }, 1.0);
+    (void)scheduler.Schedule([&calls]{ ++calls; }, 2.0);
+    (void)scheduler.SchedulePeriodic([&calls]{ ++calls; }, 1.0, 1.0);
+
+    // Act
+    const auto dropped = scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+    AdvanceMockClock(3.0);
+    const auto tokenAfterShutdown = scheduler.Schedule([&calls]{ ++calls; }, 0.0);
+
+    // Assert
+    EXPECT_EQ(3u, dropped);
+    EXPECT_EQ(0u, calls);
+    EXPECT_EQ(0u, tokenAfterShutdown);
+    EXPECT_EQ(0u, scheduler.GetStatistics().pending);
+}
+
+TEST_F(SchedulerTests, ShutdownWaitsForPeriodicCallbackHeldByExecutor) {
+    // Arrange
+    const auto executor = std::make_shared< MockExecutor >();
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.executor = executor;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::atomic< size_t > calls{0};
+    (void)scheduler.SchedulePeriodic([&calls]{ ++calls; }, 1.0, 1.0);
+    AdvanceMockClock(1.001);
+    const auto executorGotTask = executor->AwaitTasks(1);
+
+    // Act
+    auto dropped = std::async(
+        std::launch::async,
+        [this]{
+            return scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+        }
+    );
+    const auto finishedBeforeCall = (
+        dropped.wait_for(std::chrono::milliseconds(50))
+        == std::future_status::ready
+    );
+    Timekeeping::Executor::Task task;
+    {
+        std::lock_guard< decltype(executor->mutex) > lock(executor->mutex);
+        task = std::move(executor->tasks[0].first);
+        executor->tasks.clear();
+    }
+    task();
+    const auto finishedAfterCall = (
+        dropped.wait_for(std::chrono::milliseconds(1000))
+        == std::future_status::ready
+    );
+
+    // Assert
+    ASSERT_TRUE(executorGotTask);
+    EXPECT_FALSE(finishedBeforeCall);
+    ASSERT_TRUE(finishedAfterCall);
+    EXPECT_EQ(0u, dropped.get());
+    EXPECT_EQ(1u, calls);
+}
+
+TEST_F(SchedulerTests, ShutdownDoesNotWaitForPeriodicCallbackDiscardedByExecutor) {
+    // Arrange
+    const auto executor = std::make_shared< MockExecutor >();
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.executor = executor;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::atomic< size_t > calls{0};
+    (void)scheduler.SchedulePeriodic([&calls]{ ++calls; }, 1.0, 1.0);
+    AdvanceMockClock(1.001);
+    const auto executorGotTask = executor->AwaitTasks(1);
+    {
+        std::lock_guard< decltype(executor->mutex) > lock(executor->mutex);
+        executor->tasks.clear();
+    }
+
+    // Act
+    const auto dropped = scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+
+    // Assert
+    ASSERT_TRUE(executorGotTask);
+    EXPECT_EQ(1u, dropped);
+    EXPECT_EQ(0u, calls);
+}
+
+TEST_F(SchedulerTests, ShutdownRunningDueCallsOnlyCallbacksAlreadyDue) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::vector< int > called;
+    Timekeeping::Scheduler::Token tokenFromCallback = 1;
+    (void)scheduler.Schedule(
+        [this, &called, &tokenFromCallback]{
+            called.push_back(1);
+            tokenFromCallback = scheduler.Schedule([]{}, 1.0);
+        },
+        1.0
+    );
+    (void)scheduler.SchedulePeriodic([&called]{ called.push_back(2); }, 1.5, 0.1);
+    (void)scheduler.Schedule([&called]{ called.push_back(3); }, 3.0);
+    mockClock->currentTime = 2.0;
+
+    // Act
+    const auto dropped = scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::RunDue);
+
+    // Assert
+    EXPECT_EQ(std::vector< int >({1, 2}), called);
+    EXPECT_EQ(1u, dropped);
+    EXPECT_EQ(0u, tokenFromCallback);
+    EXPECT_EQ(0u, scheduler.RunDue(std::chrono::seconds(4)));
+}
+
+TEST_F(SchedulerTests, ShutdownDrainingCallsCallbacksDueWithinDrainTime) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    std::vector< int > called;
+    (void)scheduler.ScheduleAfter(
+        [&called]{ called.push_back(1); },
+        std::chrono::milliseconds(20)
+    );
+    (void)scheduler.ScheduleAfter(
+        [&called]{ called.push_back(2); },
+        std::chrono::seconds(10)
+    );
+
+    // Act
+    const auto start = std::chrono::steady_clock::now();
+    const auto dropped = scheduler.Shutdown(
+        Timekeeping::Scheduler::ShutdownPolicy::Drain,
+        std::chrono::seconds(1)
+    );
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // Assert
+    EXPECT_EQ(std::vector< int >({1}), called);
+    EXPECT_EQ(1u, dropped);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(500));
+}
+
+TEST_F(SchedulerTests, ShutdownReleasesDroppedCallbacksWithoutShardLocked) {
+    // Arrange
+    struct OnDestroyed {
+        std::function< void() > action;
+        ~OnDestroyed() {
+            action();
+        }
+    };
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    const auto otherToken = scheduler.Schedule([]{}, 10.0);
+    auto otherThreadCouldUseShard = false;
+    auto onDestroyed = std::make_shared< OnDestroyed >();
+    onDestroyed->action = [this, otherToken, &otherThreadCouldUseShard]{
+        auto rescheduled = std::async(
+            std::launch::async,
+            [this, otherToken]{ return scheduler.Reschedule(otherToken, 20.0); }
+        );
+        otherThreadCouldUseShard = (
+            rescheduled.wait_for(std::chrono::milliseconds(1000))
+            == std::future_status::ready
+        );
+    };
+    (void)scheduler.Schedule([onDestroyed]{}, 1.0);
+    std::weak_ptr< OnDestroyed > onDestroyedWeak(onDestroyed);
+    onDestroyed.reset();
+
+    // Act
+    const auto dropped = scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+
+    // Assert
+    EXPECT_EQ(2u, dropped);
+    EXPECT_TRUE(onDestroyedWeak.expired());
+    EXPECT_TRUE(otherThreadCouldUseShard);
+}
+
+TEST_F(SchedulerTests, ShutdownWaitsForLockFreeSubmissionsInProgress) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::atomic< size_t > scheduled{0};
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([this, &scheduled]{
+            for (;;) {
+                const auto token = scheduler.Schedule([]{}, 1.0);
+                if (token == 0) {
+                    break;
+                }
+                if ((++scheduled % 2) == 0) {
+                    (void)scheduler.Cancel(token);
+                }
+            }
+        });
+    }
+    while (scheduled < 1000) {
+        std::this_thread::yield();
+    }
+
+    // Act
+    (void)scheduler.Shutdown(Timekeeping::Scheduler::ShutdownPolicy::DropAll);
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    // Assert
+    EXPECT_EQ(0u, scheduler.GetStatistics().pending);
+    EXPECT_EQ(0u, scheduler.RunDue(std::chrono::seconds(2)));
+}
+
+TEST_F(SchedulerTests, SnapshotRestoresCallbacksOfRegisteredTypes) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.maxBatchSize = 10;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    Timekeeping::Scheduler::ScheduleRequest request;
+    request.callback = []{};
+    request.due = std::chrono::seconds(2);
+    request.type = 1;
+    request.key = 42;
+    (void)scheduler.Schedule(std::move(request));
+    request = Timekeeping::Scheduler::ScheduleRequest();
+    request.callback = []{};
+    request.due = std::chrono::seconds(1);
+    request.interval = std::chrono::seconds(1);
+    request.type = 1;
+    request.key = 7;
+    (void)scheduler.Schedule(std::move(request));
+    request = Timekeeping::Scheduler::ScheduleRequest();
+    request.callback = []{};
+    request.due = std::chrono::seconds(1);
+    request.type = 1;
+    request.key = 99;
+    const auto canceledToken = scheduler.Schedule(std::move(request));
+    (void)scheduler.Cancel(canceledToken);
+    request = Timekeeping::Scheduler::ScheduleRequest();
+    request.callback = []{};
+    request.due = std::chrono::seconds(1);
+    request.type = 2;
+    request.key = 5;
+    (void)scheduler.Schedule(std::move(request));
+    (void)scheduler.Schedule([]{}, 1.0);
+    const auto snapshot = scheduler.Snapshot();
+    Timekeeping::Scheduler restoredScheduler(configuration);
+    restoredScheduler.SetClock(mockClock);
+    std::vector< uint64_t > called;
+    restoredScheduler.RegisterCallbackFactory(
+        1,
+        [&called](uint64_t key) -> Timekeeping::Scheduler::Callback {
+            return [&called, key]{ called.push_back(key); };
+        }
+    );
+
+    // Act
+    auto restoredCallbacks = restoredScheduler.Restore(snapshot.data(), snapshot.size());
+    (void)restoredScheduler.RunDue(std::chrono::seconds(1));
+    const auto calledAtFirstDue = called;
+    (void)restoredScheduler.RunDue(std::chrono::seconds(2));
+
+    // Assert
+    ASSERT_EQ(2u, restoredCallbacks.size());
+    std::sort(
+        restoredCallbacks.begin(),
+        restoredCallbacks.end(),
+        [](
+            const Timekeeping::Scheduler::RestoredCallback& lhs,
+            const Timekeeping::Scheduler::RestoredCallback& rhs
+        ){ return lhs.key < rhs.key; }
+    );
+    EXPECT_EQ(7u, restoredCallbacks[0].key);
+    EXPECT_NE(0u, restoredCallbacks[0].token);
+    EXPECT_EQ(42u, restoredCallbacks[1].key);
+    EXPECT_NE(0u, restoredCallbacks[1].token);
+    EXPECT_EQ(std::vector< uint64_t >({7}), calledAtFirstDue);
+    EXPECT_EQ(std::vector< uint64_t >({7, 42, 7}), called);
+    EXPECT_TRUE(restoredScheduler.Cancel(restoredCallbacks[0].token));
+}
+
+TEST_F(SchedulerTests, SnapshotWhileSchedulingWithLockFreeSubmission) {
+    // Arrange
+    Timekeeping::Scheduler::Configuration configuration;
+    configuration.threadless = true;
+    configuration.lockFreeSubmission = true;
+    scheduler = Timekeeping::Scheduler(configuration);
+    scheduler.SetClock(mockClock);
+    std::atomic< size_t > threadsScheduling{4};
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([this, &threadsScheduling]{
+            for (int i = 0; i < 20000; ++i) {
+                Timekeeping::Scheduler::ScheduleRequest request;
+                request.callback = []{};
+                request.due = std::chrono::seconds(1);
+                request.type = 1;
+                (void)scheduler.Schedule(std::move(request));
+            }
+            --threadsScheduling;
+        });
+    }
+
+    // Act
+    size_t snapshots = 0;
+    while (threadsScheduling > 0) {
+        (void)scheduler.Snapshot();
+        ++snapshots;
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    const auto finalSnapshot = scheduler.Snapshot();
+
+    // Assert
+    EXPECT_GT(snapshots, 0u);
+    EXPECT_EQ(80000u, scheduler.GetStatistics().pending);
+    EXPECT_FALSE(finalSnapshot.empty());
+}
+
+TEST_F(SchedulerTests, RestoreIgnoresInvalidSnapshots) {
+    // Arrange
+    Timekeeping::Scheduler::ScheduleRequest request;
+    request.callback = []{};
+    request.due = std::chrono::seconds(10);
+    request.type = 1;
+    (void)scheduler.Schedule(std::move(request));
+    const auto snapshot = scheduler.Snapshot();
+    scheduler.RegisterCallbackFactory(
+        1,
+        [](uint64_t) -> Timekeeping::Scheduler::Callback { return []{}; }
+    );
+    auto corrupted = snapshot;
+    corrupted[0] ^= 1;
+
+    // Act
+    const auto restoredFromTruncated = scheduler.Restore(snapshot.data(), snapshot.size() - 1);
+    const auto restoredFromCorrupted = scheduler.Restore(corrupted.data(), corrupted.size());
+    const auto restoredFromNothing = scheduler.Restore(nullptr, 0);
+    const auto restored = scheduler.Restore(snapshot.data(), snapshot.size());
+
+    // Assert
+    EXPECT_TRUE(restoredFromTruncated.empty());
+    EXPECT_TRUE(restoredFromCorrupted.empty());
+    EXPECT_TRUE(restoredFromNothing.empty());
+    EXPECT_EQ(1u, restored.size());
+    EXPECT_EQ(2u, scheduler.GetStatistics().pending);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file ThreadPoolTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::ThreadPool class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <Timekeeping/ThreadPool.hpp>
+#include <vector>
+
+TEST(ThreadPoolTests, RunsAllTasksBeforeDestruction) {
+    // Arrange
+    std::atomic< int > tasksRun{0};
+
+    // Act
+    {
+        Timekeeping::ThreadPool pool(4);
+        for (int i = 0; i < 1000; ++i) {
+            pool.Post([&tasksRun]{ ++tasksRun; });
+        }
+    }
+
+    // Assert
+    EXPECT_EQ(1000, tasksRun);
+}
+
+TEST(ThreadPoolTests, TasksRunInParallel) {
+    // Arrange
+    Timekeeping::ThreadPool pool(4);
+    std::mutex mutex;
+    std::condition_variable allStarted;
+    size_t started = 0;
+    std::vector< std::promise< bool > > sawAllStarted(4);
+
+    // Act
+    for (size_t i = 0; i < 4; ++i) {
+        auto& result = sawAllStarted[i];
+        pool.Post([&mutex, &allStarted, &started, &result]{
+            std::unique_lock< std::mutex > lock(mutex);
+            ++started;
+            allStarted.notify_all();
+            result.set_value(
+                allStarted.wait_for(
+                    lock,
+                    std::chrono::seconds(1),
+                    [&started]{ return started == 4; }
+                )
+            );
+        });
+    }
+
+    // Assert
+    for (auto& result: sawAllStarted) {
+        EXPECT_TRUE(result.get_future().get());
+    }
+}
+
+TEST(ThreadPoolTests, StrandTasksRunOneAtATimeInOrder) {
+    // Arrange
+    std::vector< int > order;
+    std::atomic< int > running{0};
+    std::atomic< bool > overlapped{false};
+
+    // Act
+    {
+        Timekeeping::ThreadPool pool(4);
+        for (int i = 0; i < 200; ++i) {
+            pool.Post(
+                [i, &order, &running, &overlapped]{
+                    if (++running > 1) {
+                        overlapped = true;
+                    }
+                    order.push_back(i);
+                    --running;
+                },
+                42
+            );
+        }
+    }
+
+    // Assert
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(200, order.size());
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(i, order[i]);
+    }
+}
@@ -0,0 +1,195 @@
+/**
+ * @file TimerHeapTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::TimerHeap class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <src/TimerHeap.hpp>
+#include <vector>
+
+/**
+ * This is the test fixture for these tests, providing common
+ * setup and teardown for each test.
+ */
+struct TimerHeapTests
+    : public ::testing::Test
+{
+    // Properties
+
+    /**
+     * This is the table of slots holding the scheduled callbacks
+     * ordered by the unit under test.
+     */
+    Timekeeping::SlotTable slots;
+
+    /**
+     * This is the unit under test.
+     */
+    Timekeeping::TimerHeap heap{slots};
+
+    // Methods
+
+    /**
+     * Put a scheduled callback with the given due time in a new slot
+     * of the table, and add it to the heap.
+     *
+     * @param[in] due
+     *     This is the due time to give the scheduled callback.
+     *
+     * @return
+     *     The index of the slot holding the scheduled callback is returned.
+     */
+    size_t Add(int64_t due) {
+        const auto slot = slots.Add();
+        slots[slot].due = due;
+        heap.Add(slot);
+        return slot;
+    }
+
+    /**
+     * Pop every scheduled callback due by the given time, and return
+     * their due times in the order they were popped.
+     *
+     * @param[in] now
+     *     This is the time for which to pop due callbacks.
+     *
+     * @return
+     *     The due times of the popped callbacks are returned.
+     */
+    std::vector< int64_t > PopAllDue(int64_t now) {
+        std::vector< int64_t > popped;
+        size_t slot;
+        while (heap.PopDue(now, slot)) {
+            popped.push_back(slots[slot].due);
+        }
+        return popped;
+    }
+};
+
+TEST_F(TimerHeapTests, CallbacksComeOutInDueOrder) {
+    // Arrange
+    for (const int64_t due: {5, 1, 4, 2, 9, 3}) {
+        (void)Add(due);
+    }
+
+    // Act
+    const auto popped = PopAllDue(4);
+
+    // Assert
+    EXPECT_EQ(std::vector< int64_t >({1, 2, 3, 4}), popped);
+    EXPECT_FALSE(heap.IsEmpty());
+    EXPECT_EQ(5, heap.GetNextDue());
+}
+
+TEST_F(TimerHeapTests, RemoveFromMiddle) {
+    // Arrange
+    std::vector< size_t > added;
+    for (const int64_t due: {5, 1, 4, 2, 9, 3, 7}) {
+        added.push_back(Add(due));
+    }
+
+    // Act
+    heap.Remove(added[3]);
+    heap.Remove(added[1]);
+    heap.Remove(added[4]);
+
+    // Assert
+    EXPECT_EQ(std::vector< int64_t >({3, 4, 5, 7}), PopAllDue(100));
+    EXPECT_TRUE(heap.IsEmpty());
+}
+
+TEST_F(TimerHeapTests, AddMany) {
+    // Arrange
+    (void)Add(6);
+    std::vector< size_t > added;
+    for (const int64_t due: {5, 1, 4, 2, 9, 3, 7}) {
+        const auto slot = slots.Add();
+        slots[slot].due = due;
+        added.push_back(slot);
+    }
+
+    // Act
+    heap.AddMany(added);
+
+    // Assert
+    heap.Remove(added[0]);
+    EXPECT_EQ(
+        std::vector< int64_t >({1, 2, 3, 4, 6, 7, 9}),
+        PopAllDue(100)
+    );
+}
+
+TEST_F(TimerHeapTests, ManyCallbacksComeOutInDueOrderAfterRemovals) {
+    // Arrange
+    std::vector< size_t > added;
+    std::vector< int64_t > expected;
+    uint64_t random = 12345;
+    for (size_t i = 0; i < 1000; ++i) {
+        random = random * 6364136223846793005 + 1442695040888963407;
+        const auto due = (int64_t)(random >> 40);
+        added.push_back(Add(due));
+        if (i % 3 != 0) {
+            expected.push_back(due);
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    // Act
+    for (size_t i = 0; i < added.size(); i += 3) {
+        heap.Remove(added[i]);
+    }
+
+    // Assert
+    EXPECT_EQ(expected, PopAllDue(INT64_MAX));
+    EXPECT_TRUE(heap.IsEmpty());
+}
+
+TEST_F(TimerHeapTests, EqualDueTimesComeOutInOrderAdded) {
+    // Arrange
+    std::vector< size_t > added;
+    for (size_t i = 0; i < 100; ++i) {
+        added.push_back(Add((int64_t)(i % 3)));
+    }
+    std::vector< size_t > expected;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = i; j < added.size(); j += 3) {
+            expected.push_back(added[j]);
+        }
+    }
+
+    // Act
+    std::vector< size_t > popped;
+    size_t slot;
+    while (heap.PopDue(INT64_MAX, slot)) {
+        popped.push_back(slot);
+    }
+
+    // Assert
+    EXPECT_EQ(expected, popped);
+}
+
+TEST_F(TimerHeapTests, EqualDueTimesComeOutInOrderAddedAcrossRenumbering) {
+    // Arrange
+    Timekeeping::TimerHeap nearlyRenumberedHeap(slots, UINT32_MAX - 5);
+    std::vector< size_t > added;
+    for (size_t i = 0; i < 10; ++i) {
+        const auto slot = slots.Add();
+        slots[slot].due = 42;
+        nearlyRenumberedHeap.Add(slot);
+        added.push_back(slot);
+    }
+
+    // Act
+    std::vector< size_t > popped;
+    size_t slot;
+    while (nearlyRenumberedHeap.PopDue(INT64_MAX, slot)) {
+        popped.push_back(slot);
+    }
+
+    // Assert
+    EXPECT_EQ(added, popped);
+}
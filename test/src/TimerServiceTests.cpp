@@ -0,0 +1,239 @@
+/**
+ * @file TimerServiceTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::TimerService
+ * class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <Timekeeping/Clock.hpp>
+#include <Timekeeping/TimerService.hpp>
+
+namespace {
+
+    /**
+     * This is a fake clock which is used to test the timer service.
+     */
+    struct MockClock
+        : public Timekeeping::Clock
+    {
+        // Properties
+
+        std::atomic< double > currentTime{0.0};
+
+        // Methods
+
+        // Clock
+
+        virtual double GetCurrentTime() override {
+            return currentTime;
+        }
+    };
+
+    /**
+     * Return whether or not the given future becomes ready soon.
+     *
+     * @param[in] future
+     *     This is the future to check.
+     *
+     * @return
+     *     An indication of whether or not the future became ready soon
+     *     is returned.
+     */
+    bool BecomesReady(std::future< void >& future) {
+        return (
+            future.wait_for(std::chrono::milliseconds(1000))
+            == std::future_status::ready
+        );
+    }
+
+}
+
+/**
+ * This is the test fixture for these tests, providing common
+ * setup and teardown for each test.
+ */
+struct TimerServiceTests
+    : public ::testing::Test
+{
+    // Properties
+
+    /**
+     * This is the unit under test.
+     */
+    Timekeeping::TimerService service;
+
+    /**
+     * This is the mock for the clock which drives the service.
+     */
+    std::shared_ptr< MockClock > mockClock = std::make_shared< MockClock >();
+
+    // ::testing::Test
+
+    virtual void SetUp() override {
+        service.MakeScheduler().SetClock(mockClock);
+    }
+
+    virtual void TearDown() override {
+    }
+};
+
+TEST_F(TimerServiceTests, SchedulersShareTheClockAndCallTheirCallbacks) {
+    // Arrange
+    auto first = service.MakeScheduler();
+    auto second = service.MakeScheduler();
+    std::promise< void > firstCalled;
+    auto firstCalledFuture = firstCalled.get_future();
+    std::promise< void > secondCalled;
+    auto secondCalledFuture = secondCalled.get_future();
+    (void)first.Schedule([&firstCalled]{ firstCalled.set_value(); }, 1.0);
+    (void)second.Schedule([&secondCalled]{ secondCalled.set_value(); }, 2.0);
+
+    // Act
+    mockClock->currentTime = 2.001;
+    first.WakeUp();
+
+    // Assert
+    EXPECT_EQ(mockClock, second.GetClock());
+    EXPECT_TRUE(BecomesReady(firstCalledFuture));
+    EXPECT_TRUE(BecomesReady(secondCalledFuture));
+}
+
+TEST_F(TimerServiceTests, DestroyingSchedulerCancelsOnlyItsOwnCallbacks) {
+    // Arrange
+    auto kept = service.MakeScheduler();
+    std::promise< void > keptCalled;
+    auto keptCalledFuture = keptCalled.get_future();
+    (void)kept.Schedule([&keptCalled]{ keptCalled.set_value(); }, 1.0);
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    std::atomic< bool > destroyedCalled{false};
+    {
+        auto destroyed = service.MakeScheduler();
+        (void)destroyed.Schedule(
+            [captured, &destroyedCalled]{ destroyedCalled = true; },
+            1.0
+        );
+        (void)destroyed.SchedulePeriodic(
+            [captured, &destroyedCalled]{ destroyedCalled = true; },
+            1.0,
+            1.0
+        );
+    }
+    captured.reset();
+
+    // Act
+    mockClock->currentTime = 1.001;
+    kept.WakeUp();
+    const auto wasKeptCalled = BecomesReady(keptCalledFuture);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // Assert
+    EXPECT_TRUE(wasKeptCalled);
+    EXPECT_FALSE(destroyedCalled);
+    EXPECT_TRUE(capturedWeak.expired());
+}
+
+TEST_F(TimerServiceTests, SchedulerOnlyCancelsAndReschedulesItsOwnCallbacks) {
+    // Arrange
+    auto owner = service.MakeScheduler();
+    auto other = service.MakeScheduler();
+    std::promise< void > called;
+    auto calledFuture = called.get_future();
+    const auto token = owner.Schedule([&called]{ called.set_value(); }, 1.0);
+
+    // Act
+    other.Cancel(token);
+    other.CancelMany({token});
+    const auto wasRescheduledByOther = other.Reschedule(token, 5.0);
+    const auto wasRescheduledByOwner = owner.Reschedule(token, 2.0);
+    mockClock->currentTime = 2.001;
+    owner.WakeUp();
+
+    // Assert
+    EXPECT_FALSE(wasRescheduledByOther);
+    EXPECT_TRUE(wasRescheduledByOwner);
+    EXPECT_TRUE(BecomesReady(calledFuture));
+}
+
+TEST_F(TimerServiceTests, SchedulerCanOutliveService) {
+    // Arrange
+    auto scheduler = service.MakeScheduler();
+    std::promise< void > called;
+    auto calledFuture = called.get_future();
+    (void)scheduler.Schedule([&called]{ called.set_value(); }, 1.0);
+
+    // Act
+    service = Timekeeping::TimerService();
+    mockClock->currentTime = 1.001;
+    scheduler.WakeUp();
+
+    // Assert
+    EXPECT_TRUE(BecomesReady(calledFuture));
+}
+
+TEST_F(TimerServiceTests, LastSchedulerCanBeDestroyedWhileItsCallbackFinishes) {
+    // Arrange
+    auto scheduler = std::unique_ptr< Timekeeping::Scheduler >(
+        new Timekeeping::Scheduler(service.MakeScheduler())
+    );
+    std::promise< void > called;
+    auto calledFuture = called.get_future();
+    (void)scheduler->Schedule(
+        [&called]{
+            called.set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        },
+        1.0
+    );
+    service = Timekeeping::TimerService();
+    mockClock->currentTime = 1.001;
+    scheduler->WakeUp();
+    const auto wasCalled = BecomesReady(calledFuture);
+
+    // Act
+    scheduler.reset();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Assert
+    EXPECT_TRUE(wasCalled);
+}
+
+TEST_F(TimerServiceTests, SchedulerStopsTrackingCallbacksOnceCalled) {
+    // Arrange
+    auto scheduler = service.MakeScheduler();
+    std::atomic< int > calls{0};
+    std::promise< void > allCalled;
+    auto allCalledFuture = allCalled.get_future();
+    for (int i = 0; i < 200; ++i) {
+        (void)scheduler.Schedule(
+            [&calls, &allCalled]{
+                if (++calls == 200) {
+                    allCalled.set_value();
+                }
+            },
+            1.0
+        );
+    }
+    mockClock->currentTime = 1.001;
+    scheduler.WakeUp();
+    const auto wereAllCalled = BecomesReady(allCalledFuture);
+    const auto token = scheduler.Schedule([]{}, 10.0);
+
+    // Act
+    const auto tracked = scheduler.Shutdown(
+        Timekeeping::Scheduler::ShutdownPolicy::DropAll
+    );
+
+    // Assert
+    EXPECT_TRUE(wereAllCalled);
+    EXPECT_NE(0u, token);
+    EXPECT_EQ(1u, tracked);
+}
@@ -0,0 +1,162 @@
+/**
+ * @file TimingWheelTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::TimingWheel class.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <gtest/gtest.h>
+#include <src/TimingWheel.hpp>
+#include <Timekeeping/Clock.hpp>
+#include <vector>
+
+/**
+ * This is the test fixture for these tests, providing common
+ * setup and teardown for each test.
+ */
+struct TimingWheelTests
+    : public ::testing::Test
+{
+    // Properties
+
+    /**
+     * This is the table of slots holding the scheduled callbacks
+     * ordered by the unit under test.
+     */
+    Timekeeping::SlotTable slots;
+
+    /**
+     * This is the unit under test.
+     */
+    Timekeeping::TimingWheel wheel{slots, 0.001};
+
+    // Methods
+
+    /**
+     * Convert the given time in seconds to clock ticks.
+     *
+     * @param[in] seconds
+     *     This is the time to convert.
+     *
+     * @return
+     *     The given time in clock ticks is returned.
+     */
+    static int64_t Ticks(double seconds) {
+        return Timekeeping::Clock::SecondsToTicks(seconds);
+    }
+
+    /**
+     * Put a scheduled callback with the given due time in a new slot
+     * of the table, and add it to the wheel.
+     *
+     * @param[in] due
+     *     This is the due time to give the scheduled callback.
+     *
+     * @return
+     *     The index of the slot holding the scheduled callback is returned.
+     */
+    size_t Add(int64_t due) {
+        const auto slot = slots.Add();
+        slots[slot].due = due;
+        wheel.Add(slot);
+        return slot;
+    }
+};
+
+TEST_F(TimingWheelTests, NotDueBeforeDueTime) {
+    // Arrange
+    const auto added = Add(Ticks(10.0));
+    size_t slot = Timekeeping::NO_SLOT;
+
+    // Act
+    const auto poppedEarly = wheel.PopDue(Ticks(9.9995), slot);
+    const auto poppedOnTime = wheel.PopDue(Ticks(10.0005), slot);
+
+    // Assert
+    EXPECT_FALSE(poppedEarly);
+    EXPECT_TRUE(poppedOnTime);
+    EXPECT_EQ(added, slot);
+    EXPECT_TRUE(wheel.IsEmpty());
+}
+
+TEST_F(TimingWheelTests, PastDueIsReadyImmediately) {
+    // Arrange
+    size_t slot = Timekeeping::NO_SLOT;
+    (void)wheel.PopDue(Ticks(100.0), slot);
+
+    // Act
+    const auto added = Add(Ticks(50.0));
+    const auto popped = wheel.PopDue(Ticks(100.0), slot);
+
+    // Assert
+    EXPECT_TRUE(popped);
+    EXPECT_EQ(added, slot);
+}
+
+TEST_F(TimingWheelTests, CallbacksComeOutInTickOrder) {
+    // Arrange
+    const std::vector< double > dueTimes{
+        3600.0, 0.005, 70.25, 0.064, 1.0, 0.063, 4096.123, 0.5,
+    };
+    for (const auto due: dueTimes) {
+        (void)Add(Ticks(due));
+    }
+
+    // Act
+    std::vector< double > popped;
+    size_t slot;
+    while (wheel.PopDue(Ticks(5000.0), slot)) {
+        popped.push_back(Timekeeping::Clock::TicksToSeconds(slots[slot].due));
+    }
+
+    // Assert
+    EXPECT_EQ(
+        std::vector< double >({
+            0.005, 0.063, 0.064, 0.5, 1.0, 70.25, 3600.0, 4096.123,
+        }),
+        popped
+    );
+    EXPECT_TRUE(wheel.IsEmpty());
+}
+
+TEST_F(TimingWheelTests, NextDueLeadsToCallbackWithoutCallingItEarly) {
+    // Arrange
+    auto now = Ticks(1546300800.0);
+    size_t slot;
+    (void)wheel.PopDue(now, slot);
+    const auto due = now + Ticks(12345.678);
+    const auto added = Add(due);
+
+    // Act
+    size_t wakeUps = 0;
+    while (!wheel.PopDue(now, slot)) {
+        ASSERT_LT(now, due);
+        ASSERT_LT(wakeUps, 100);
+        ++wakeUps;
+        now = wheel.GetNextDue();
+    }
+
+    // Assert
+    EXPECT_EQ(added, slot);
+    EXPECT_GE(now, due);
+    EXPECT_LT(now - due, Ticks(0.002));
+}
+
+TEST_F(TimingWheelTests, Remove) {
+    // Arrange
+    const auto first = Add(Ticks(1.0));
+    const auto second = Add(Ticks(1.0));
+    const auto third = Add(Ticks(2000.0));
+
+    // Act
+    wheel.Remove(first);
+    wheel.Remove(third);
+
+    // Assert
+    size_t slot;
+    ASSERT_TRUE(wheel.PopDue(Ticks(5000.0), slot));
+    EXPECT_EQ(second, slot);
+    EXPECT_FALSE(wheel.PopDue(Ticks(5000.0), slot));
+    EXPECT_TRUE(wheel.IsEmpty());
+}
@@ -0,0 +1,156 @@
+/**
+ * @file UniqueFunctionTests.cpp
+ *
+ * This module contains the unit tests of the Timekeeping::UniqueFunction
+ * class template.
+ *
+ * © 2019 by Richard Walters
+ */
+
+#include <functional>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stddef.h>
+#include <Timekeeping/UniqueFunction.hpp>
+
+namespace {
+
+    /**
+     * This counts how many times a callable of a test type
+     * was allocated from the heap.
+     */
+    size_t heapAllocations = 0;
+
+    /**
+     * This is a callable which counts its own heap allocations, and
+     * which can be made big enough not to fit inside a UniqueFunction.
+     *
+     * @tparam Size
+     *     This is the number of bytes of padding to put in the callable.
+     */
+    template< size_t Size > struct CountingCallable {
+        // Properties
+
+        char padding[Size];
+
+        // Methods
+
+        void operator()() {
+        }
+
+        static void* operator new(size_t size) {
+            ++heapAllocations;
+            return ::operator new(size);
+        }
+
+        static void operator delete(void* pointer) {
+            ::operator delete(pointer);
+        }
+    };
+
+    /**
+     * This is a callable which owns a value that can't be copied.
+     */
+    struct MoveOnlyCallable {
+        // Properties
+
+        std::unique_ptr< int > value;
+
+        // Methods
+
+        int operator()() {
+            return *value;
+        }
+    };
+
+}
+
+TEST(UniqueFunctionTests, SmallCallableDoesNotAllocate) {
+    // Arrange
+    heapAllocations = 0;
+
+    // Act
+    Timekeeping::UniqueFunction< void() > function(CountingCallable< 8 >{});
+    function();
+
+    // Assert
+    EXPECT_EQ(0, heapAllocations);
+    EXPECT_TRUE(
+        Timekeeping::UniqueFunction< void() >::StoresInline<
+            CountingCallable< 8 >
+        >()
+    );
+}
+
+TEST(UniqueFunctionTests, LargeCallableAllocatesOnce) {
+    // Arrange
+    heapAllocations = 0;
+    using BigCallable = CountingCallable<
+        Timekeeping::UniqueFunction< void() >::INLINE_SIZE + 1
+    >;
+
+    // Act
+    Timekeeping::UniqueFunction< void() > function(BigCallable{});
+    auto moved = std::move(function);
+    moved();
+
+    // Assert
+    EXPECT_EQ(1, heapAllocations);
+    EXPECT_FALSE(
+        Timekeeping::UniqueFunction< void() >::StoresInline< BigCallable >()
+    );
+}
+
+TEST(UniqueFunctionTests, MoveOnlyCallable) {
+    // Arrange
+    MoveOnlyCallable callable;
+    callable.value.reset(new int(42));
+
+    // Act
+    Timekeeping::UniqueFunction< int() > function(std::move(callable));
+    auto moved = std::move(function);
+
+    // Assert
+    EXPECT_FALSE((bool)function);
+    ASSERT_TRUE((bool)moved);
+    EXPECT_EQ(42, moved());
+}
+
+TEST(UniqueFunctionTests, ArgumentsAndReturnValue) {
+    // Arrange
+    Timekeeping::UniqueFunction< int(int, const std::string&) > function(
+        [](int x, const std::string& y){ return x + (int)y.length(); }
+    );
+
+    // Act
+    const auto result = function(3, "Hello");
+
+    // Assert
+    EXPECT_EQ(8, result);
+}
+
+TEST(UniqueFunctionTests, ResetDestroysCallable) {
+    // Arrange
+    auto captured = std::make_shared< int >(42);
+    std::weak_ptr< int > capturedWeak(captured);
+    Timekeeping::UniqueFunction< void() > function([captured]{});
+    captured.reset();
+
+    // Act
+    const auto wasAliveBeforeReset = !capturedWeak.expired();
+    function = nullptr;
+
+    // Assert
+    EXPECT_TRUE(wasAliveBeforeReset);
+    EXPECT_TRUE(capturedWeak.expired());
+    EXPECT_FALSE((bool)function);
+}
+
+TEST(UniqueFunctionTests, CallEmptyThrows) {
+    // Arrange
+    Timekeeping::UniqueFunction< void() > function;
+
+    // Act
+    // Assert
+    EXPECT_THROW(function(), std::bad_function_call);
+}